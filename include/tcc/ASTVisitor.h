@@ -1,32 +1,74 @@
 ﻿// Tough C Profiler - AST Visitor
 // Tough C 分析器 - AST 访问者
 //
-// Base class for traversing Clang AST and applying rules
-// 用于遍历 Clang AST 和应用规则的基类
+// Single fused traversal that dispatches AST nodes to interested rules
+// 将 AST 节点分发给感兴趣规则的单次融合遍历
 
 #pragma once
 
 #include "tcc/Core.h"
 #include "tcc/Diagnostic.h"
+#include "tcc/MatcherRule.h"
 #include "tcc/Rule.h"
+#include "tcc/TimeReport.h"
 
 #include <clang/AST/ASTContext.h>
 #include <clang/AST/RecursiveASTVisitor.h>
 #include <clang/AST/Decl.h>
 #include <clang/AST/Expr.h>
 #include <clang/AST/Stmt.h>
+#include <clang/Basic/SourceManager.h>
+
+#include <mutex>
+#include <vector>
 
 namespace tcc {
 
+// Main-file test shared by the visitors of one sharded traversal
+// 一次分片遍历中各访问者共享的主文件判断
+// File locations inside the main file's buffer are answered from its
+// offset range. Anything else asks the SourceManager under `mutex`, since
+// its lookup caches are not thread-safe; other users of it share `mutex`.
+// 主文件缓冲区内的文件位置按偏移范围直接判断。其他位置在 `mutex` 内询问 SourceManager，
+// 因为其查找缓存不是线程安全的；它的其他使用者共享 `mutex`。
+class MainFileFilter {
+public:
+    MainFileFilter(const clang::SourceManager& sm, std::mutex& mutex);
+    
+    bool contains(clang::SourceLocation loc) const;
+
+private:
+    const clang::SourceManager& sm_;
+    clang::SourceLocation begin_;
+    clang::SourceLocation end_;
+    bool offsetsExact_ = false;   // No #line directives in the main file / 主文件中没有 #line 指令
+    std::mutex& mutex_;
+};
+
 // Main AST visitor that applies all rules / 应用所有规则的主 AST 访问者
 class TCCASTVisitor : public clang::RecursiveASTVisitor<TCCASTVisitor> {
+    using Base = clang::RecursiveASTVisitor<TCCASTVisitor>;
+
 public:
-    explicit TCCASTVisitor(clang::ASTContext& context,
-                          const std::vector<std::unique_ptr<Rule>>& rules,
-                          DiagnosticEngine& diagnostics)
+    // Traversal stops at the next declaration or hook once `cancel` is set.
+    // Visitors running on several threads share a `mainFile` filter.
+    // `cancel` 被设置后，遍历在下一个声明或钩子处停止。在多个线程上运行的访问者共享 `mainFile` 过滤器。
+    TCCASTVisitor(clang::ASTContext& context,
+                  const RuleDispatchTable& dispatch,
+                  DiagnosticEngine& diagnostics,
+                  const CancellationToken& cancel,
+                  const MainFileFilter* mainFile = nullptr)
         : context_(context)
-        , rules_(rules)
-        , diagnostics_(diagnostics) {}
+        , dispatch_(dispatch)
+        , diagnostics_(diagnostics)
+        , cancel_(cancel)
+        , mainFile_(mainFile) {}
+    
+    // Track the enclosing function for return statements
+    // 为 return 语句跟踪外围函数
+    bool TraverseDecl(clang::Decl* decl);
+    bool TraverseLambdaExpr(clang::LambdaExpr* expr,
+                            DataRecursionQueue* queue = nullptr);
     
     // Visit function declarations / 访问函数声明
     bool VisitFunctionDecl(clang::FunctionDecl* decl);
@@ -34,20 +76,31 @@ public:
     // Visit variable declarations / 访问变量声明
     bool VisitVarDecl(clang::VarDecl* decl);
     
+    // Visit field declarations / 访问字段声明
+    bool VisitFieldDecl(clang::FieldDecl* decl);
+    
+    // Visit class definitions / 访问类定义
+    bool VisitCXXRecordDecl(clang::CXXRecordDecl* decl);
+    
     // Visit new expressions / 访问 new 表达式
     bool VisitCXXNewExpr(clang::CXXNewExpr* expr);
     
     // Visit delete expressions / 访问 delete 表达式
     bool VisitCXXDeleteExpr(clang::CXXDeleteExpr* expr);
     
+    // Visit calls / 访问函数调用
+    bool VisitCallExpr(clang::CallExpr* expr);
+    
     // Visit return statements / 访问 return 语句
     bool VisitReturnStmt(clang::ReturnStmt* stmt);
     
     // Visit lambda expressions / 访问 lambda 表达式
     bool VisitLambdaExpr(clang::LambdaExpr* expr);
     
-    // Visit thread creation / 访问线程创建
-    bool VisitCXXConstructExpr(clang::CXXConstructExpr* expr);
+    // Run the dispatch table's matcher rules in one pass over the traversal
+    // scope, sharing this visitor's type classifier
+    // 在对遍历范围的一次扫描中运行分发表的匹配器规则，共享此访问者的类型分类器
+    void runMatchers();
     
     // Helper: Get source location / 辅助函数：获取源位置
     SourceLocation getSourceLocation(clang::SourceLocation loc) const;
@@ -56,9 +109,41 @@ public:
     bool isInMainFile(clang::SourceLocation loc) const;
 
 private:
+    // Run the handlers of `Kind` on a main-file node, timing profiled rules;
+    // false once cancelled / 对主文件节点运行 `Kind` 的处理函数并为被分析的规则计时；取消后返回 false
+    template <NodeKind Kind>
+    bool notify(typename NodeTraits<Kind>::Node* node, clang::SourceLocation loc) {
+        const auto& hooks = dispatch_.hooksFor<Kind>();
+        if (hooks.empty() || !isInMainFile(loc)) {
+            return true;
+        }
+        
+        NodeHookContext hook{context_, diagnostics_,
+                             functionStack_.empty() ? nullptr : functionStack_.back(), types_};
+        for (const auto& handler : hooks) {
+            if (!handler.stats) {
+                handler.call(handler.rule, node, hook);
+                continue;
+            }
+            
+            size_t before = diagnostics_.getDiagnostics().size();
+            Stopwatch stopwatch;
+            handler.call(handler.rule, node, hook);
+            handler.stats->wallSeconds += stopwatch.wallSeconds();
+            handler.stats->cpuSeconds += stopwatch.cpuSeconds();
+            handler.stats->nodes += 1;
+            handler.stats->diagnostics += diagnostics_.getDiagnostics().size() - before;
+        }
+        return !cancel_.isCancelled();
+    }
+    
     clang::ASTContext& context_;
-    const std::vector<std::unique_ptr<Rule>>& rules_;
+    const RuleDispatchTable& dispatch_;
     DiagnosticEngine& diagnostics_;
+    const CancellationToken& cancel_;
+    const MainFileFilter* mainFile_;   // Null on a single thread / 单线程时为空
+    std::vector<clang::FunctionDecl*> functionStack_;  // Enclosing functions / 外围函数
+    TypeClassifier types_;   // One per TU traversal / 每次翻译单元遍历一个
 };
 
 } // namespace tcc
@@ -0,0 +1,81 @@
+﻿// Tough C Profiler - Allocation API Catalog
+// Tough C 分析器 - 分配 API 目录
+//
+// Functions whose direct calls are forbidden or sanctioned in TCC code
+// 在 TCC 代码中禁止或允许直接调用的函数
+
+#pragma once
+
+#include <llvm/ADT/DenseMap.h>
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace clang {
+class ASTContext;
+class FunctionDecl;
+class IdentifierInfo;
+}
+
+namespace tcc {
+
+// Role of a catalogued function / 目录中函数的角色
+enum class ApiKind : uint8_t {
+    None,           // Not catalogued / 未收录
+    Allocation,     // Returns memory the caller must release / 返回需由调用方释放的内存
+    Deallocation,   // Releases such memory / 释放此类内存
+    Sanctioned      // Explicitly allowed, overriding a built-in entry / 明确允许，覆盖内置条目
+};
+
+// File format, one entry per line / 文件格式，每行一个条目:
+//   # comment
+//   alloc   pool_alloc
+//   release pool_free
+//   allow   strdup
+// Names are unqualified; "operator new", "operator new[]", "operator
+// delete" and "operator delete[]" name explicit operator calls. Later
+// entries replace earlier ones, including the built-ins.
+// 名称不带限定；"operator new"、"operator new[]"、"operator delete" 和
+// "operator delete[]" 表示显式的运算符调用。后面的条目替换前面的条目，包括内置条目。
+
+// Run-wide catalog, read-only once loaded and safe to share between workers
+// 整个运行共用的目录，加载后只读，可在工作线程间共享
+class ApiCatalog {
+public:
+    // Starts with the built-in C, POSIX and operator allocation functions
+    // 初始包含内置的 C、POSIX 和运算符分配函数
+    ApiCatalog();
+    
+    // Shared catalog with the built-ins only / 仅含内置条目的共享目录
+    static const ApiCatalog& builtin();
+    
+    // Add the entries of `path`; false with `error` set on a malformed file
+    // 添加 `path` 中的条目；文件格式错误时返回 false 并设置 `error`
+    bool load(const std::string& path, std::string& error);
+    
+    // Identifies the entries in cache keys / 在缓存键中标识条目
+    std::string getSignature() const;
+    
+    // Catalog compiled against one TU's identifier table, so a call check
+    // is a pointer lookup with no string building
+    // 针对某个翻译单元标识符表编译的目录，调用检查只是一次指针查找，无需构建字符串
+    class Lookup {
+    public:
+        Lookup(const ApiCatalog& catalog, const clang::ASTContext& context);
+        
+        ApiKind classify(const clang::FunctionDecl& callee) const;
+    
+    private:
+        llvm::DenseMap<const clang::IdentifierInfo*, ApiKind> identifiers_;
+        std::array<ApiKind, 4> operators_{};   // new, new[], delete, delete[]
+    };
+
+private:
+    void add(const std::string& name, ApiKind kind);
+    
+    std::map<std::string, ApiKind> entries_;   // Ordered for the signature / 为签名保持有序
+};
+
+} // namespace tcc
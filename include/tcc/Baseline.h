@@ -0,0 +1,128 @@
+﻿// Tough C Profiler - Violation Baseline
+// Tough C 分析器 - 违规基线
+//
+// Accepted existing violations, so only new ones are reported
+// 已接受的现有违规，只报告新增违规
+
+#pragma once
+
+#include "tcc/Diagnostic.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace llvm {
+class MemoryBuffer;
+}
+
+namespace tcc {
+
+// File format, one entry per line, sorted / 文件格式，每行一个条目，已排序:
+//   # tcc-baseline 1
+//   <16 hex digit fingerprint> <rule ID> <file>
+// The fingerprint hashes the file (relative to the baseline's directory),
+// the message arguments and the whitespace-free text of the flagged line
+// and its two neighbours, so it survives lines shifting above it. The
+// file column is informational.
+// 指纹哈希文件（相对于基线所在目录）、消息参数以及被标记行及其上下两行去除空白后的文本，
+// 因此上方行号偏移不影响它。file 列仅供阅读。
+
+// Source lines by file, loaded on first use / 按文件缓存的源代码行，首次使用时加载
+class SourceTextCache {
+public:
+    SourceTextCache();
+    ~SourceTextCache();
+    
+    // Copy of 1-based `line` of `file`, empty if unavailable / `file` 第 `line` 行（从 1 开始）的副本，不可用时为空
+    std::string getLine(StringId file, unsigned line);
+
+private:
+    struct File {
+        std::unique_ptr<llvm::MemoryBuffer> buffer;   // Null if unreadable / 不可读时为空
+        std::vector<uint32_t> lineStarts;
+    };
+    
+    std::mutex mutex_;
+    std::unordered_map<StringId, File> files_;
+};
+
+// Fingerprint of a diagnostic and the path it is stored under
+// 诊断的指纹及其存储路径
+struct BaselineEntry {
+    uint64_t fingerprint;
+    std::string file;
+};
+
+// Compute the entry of `diag`; paths under `root` are made relative to it
+// 计算 `diag` 的条目；`root` 下的路径转换为相对路径
+BaselineEntry computeBaselineEntry(const Diagnostic& diag, const std::string& root,
+                                   SourceTextCache& sources);
+
+// Loaded baseline, read-only and safe to share between workers
+// 已加载的基线，只读，可在工作线程间共享
+class Baseline {
+public:
+    // Read `path`; false with `error` set if it is not a baseline
+    // 读取 `path`；若不是基线文件则返回 false 并设置 `error`
+    bool load(const std::string& path, std::string& error);
+    
+    size_t size() const { return keys_.size(); }
+    
+    // Whether `diag` is an accepted violation / `diag` 是否为已接受的违规
+    bool contains(const Diagnostic& diag) const;
+    
+    // Drop accepted diagnostics and their counts; returns how many were dropped
+    // 丢弃已接受的诊断及其计数；返回丢弃的数量
+    size_t filter(DiagnosticEngine& diagnostics) const;
+
+private:
+    // Open-addressing set of keys; they are already hashes, so the low bits
+    // pick the slot directly / 键的开放寻址集合；键本身已是哈希值，低位直接选槽
+    class KeySet {
+    public:
+        // Size for `count` keys without growing / 按 `count` 个键分配，无需扩容
+        void reserve(size_t count);
+        void insert(uint64_t key);
+        bool contains(uint64_t key) const;
+        size_t size() const { return size_; }
+        void clear();
+    
+    private:
+        std::vector<uint64_t> slots_;   // 0 = empty / 0 = 空
+        size_t size_ = 0;
+    };
+    
+    std::string root_;
+    KeySet keys_;   // Rule ID mixed with fingerprint / 规则 ID 与指纹混合
+    mutable SourceTextCache sources_;
+};
+
+// Sink writing every diagnostic it sees as a baseline / 将收到的每个诊断写为基线的接收器
+class BaselineWriter : public DiagnosticSink {
+public:
+    explicit BaselineWriter(std::string path);
+    
+    void handle(const Diagnostic& diag) override;
+    void finish() override;
+    
+    // Distinct entries written / 写入的不同条目数
+    size_t getEntryCount() const { return entryCount_; }
+    
+    // Empty unless finish() failed / finish() 失败时非空
+    const std::string& getError() const { return error_; }
+
+private:
+    std::string path_;
+    std::string root_;
+    std::string error_;
+    std::vector<std::string> lines_;
+    size_t entryCount_ = 0;
+    SourceTextCache sources_;
+};
+
+} // namespace tcc
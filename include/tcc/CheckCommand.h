@@ -0,0 +1,26 @@
+﻿// Tough C Profiler - Check Command
+// Tough C 分析器 - 检查命令
+//
+// The tcc-check command line, shared by the CLI and the daemon
+// tcc-check 命令行，由 CLI 和守护进程共用
+
+#pragma once
+
+namespace llvm {
+class raw_ostream;
+}
+
+namespace tcc {
+
+class CancellationToken;
+
+// Parse arguments, check the files and print results; returns an ExitCode.
+// Command line options are global, so calls must not overlap. Cancelling
+// `cancel` stops the check early, leaving partial results.
+// 解析参数、检查文件并打印结果；返回 ExitCode。
+// 命令行选项是全局的，因此调用不能重叠。取消 `cancel` 会提前停止检查，只留下部分结果。
+int runCheckCommand(int argc, const char** argv,
+                    llvm::raw_ostream& out, llvm::raw_ostream& err,
+                    CancellationToken* cancel = nullptr);
+
+} // namespace tcc
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include "tcc/MatcherRule.h"
 #include "tcc/Rule.h"
 #include <clang/AST/Decl.h>
 #include <clang/AST/Expr.h>
@@ -14,30 +15,40 @@ namespace tcc {
 
 // Rule: Forbid unsynchronized shared mutable state
 // 规则：禁止非同步共享可变状态
-class ForbidUnsyncSharedStateRule : public ConcurrencyRule {
+class ForbidUnsyncSharedStateRule
+    : public MatcherRule<ForbidUnsyncSharedStateRule, ConcurrencyRule, NodeKind::VarDecl> {
 public:
     ForbidUnsyncSharedStateRule()
-        : ConcurrencyRule("TCC-CONC-001",
-                         "Unsynchronized shared mutable state / "
-                         "非同步共享可变状态") {}
+        : MatcherRule("TCC-CONC-001",
+                     "Unsynchronized shared mutable state / "
+                     "非同步共享可变状态") {}
     
-    void check(clang::ASTContext& context, DiagnosticEngine& diagnostics) override;
-    
-    // Check if variable is mutable and potentially shared
-    // 检查变量是否可变且可能被共享
-    bool isMutableSharedState(clang::VarDecl* decl) const;
+    // Match non-const globals and statics / 匹配非 const 的全局和静态变量
+    void registerMatchers(clang::ast_matchers::MatchFinder& finder,
+                          clang::ast_matchers::MatchFinder::MatchCallback* callback);
+    void onMatch(const clang::ast_matchers::MatchFinder::MatchResult& result,
+                 const NodeHookContext& hook);
 };
 
 // Rule: Forbid capturing non-const references in thread lambda
 // 规则：禁止在线程 lambda 中捕获非 const 引用
-class ForbidNonConstLambdaCaptureRule : public ConcurrencyRule {
+class ForbidNonConstLambdaCaptureRule
+    : public NodeRule<ForbidNonConstLambdaCaptureRule, ConcurrencyRule, NodeKind::LambdaExpr> {
 public:
     ForbidNonConstLambdaCaptureRule()
-        : ConcurrencyRule("TCC-CONC-002",
-                         "Capturing non-const reference in thread lambda / "
-                         "在线程 lambda 中捕获非 const 引用") {}
+        : NodeRule("TCC-CONC-002",
+                  "Capturing non-const reference in thread lambda / "
+                  "在线程 lambda 中捕获非 const 引用",
+                  RuleCost::Moderate) {}
     
-    void check(clang::ASTContext& context, DiagnosticEngine& diagnostics) override;
+    void checkLambdaExpr(clang::LambdaExpr* lambda,
+                        clang::ASTContext& context,
+                        DiagnosticEngine& diagnostics);
+
+private:
+    void reportViolation(clang::LambdaExpr* lambda,
+                        clang::ASTContext& context,
+                        DiagnosticEngine& diagnostics);
 };
 
 // Rule: Forbid sharing raw pointers across threads
@@ -47,9 +58,11 @@ public:
     ForbidRawPtrThreadSharingRule()
         : ConcurrencyRule("TCC-CONC-003",
                          "Sharing raw pointer across threads / "
-                         "跨线程共享原始指针") {}
+                         "跨线程共享原始指针",
+                         RuleCost::Expensive) {}
     
-    void check(clang::ASTContext& context, DiagnosticEngine& diagnostics) override;
+    void check(clang::ASTContext& context, DiagnosticEngine& diagnostics,
+               const CancellationToken& cancel) override;
 };
 
 // Rule: Require std::atomic for shared counters
@@ -59,9 +72,11 @@ public:
     RequireAtomicForSharedCounterRule()
         : ConcurrencyRule("TCC-CONC-004",
                          "Non-atomic shared counter / "
-                         "非原子共享计数器") {}
+                         "非原子共享计数器",
+                         RuleCost::Expensive) {}
     
-    void check(clang::ASTContext& context, DiagnosticEngine& diagnostics) override;
+    void check(clang::ASTContext& context, DiagnosticEngine& diagnostics,
+               const CancellationToken& cancel) override;
 };
 
 } // namespace tcc
@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
@@ -29,20 +31,32 @@ enum class ExitCode : int {
 };
 
 // Severity levels for diagnostics / 诊断严重程度级别
-enum class Severity {
+enum class Severity : uint8_t {
     Error,    // Must fix / 必须修复
     Warning,  // Should fix / 应该修复
     Note      // Informational / 信息提示
 };
 
 // Rule categories / 规则类别
-enum class RuleCategory {
+enum class RuleCategory : uint8_t {
     Ownership,     // Ownership and smart pointers / 所有权和智能指针
     Lifetime,      // Reference and pointer lifetime / 引用和指针生命周期
     Concurrency,   // Thread safety / 线程安全
     TypeSafety     // Type system safety / 类型系统安全 (future)
 };
 
+// Cooperative stop request shared by workers and rule traversals; whoever
+// holds it polls isCancelled() at safe points and unwinds on its own
+// 工作线程与规则遍历共享的协作式停止请求；持有者在安全点轮询 isCancelled() 并自行退出
+class CancellationToken {
+public:
+    void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+    bool isCancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> cancelled_{false};
+};
+
 // Forward declarations / 前向声明
 class Diagnostic;
 class RuleEngine;
@@ -0,0 +1,42 @@
+﻿// Tough C Profiler - Daemon Protocol
+// Tough C 分析器 - 守护进程协议
+//
+// Wire format between tcc-check-client and tcc-checkd over a UNIX socket.
+// Kept free of LLVM so the client stays thin.
+// tcc-check-client 与 tcc-checkd 之间经 UNIX 套接字的传输格式。
+// 不依赖 LLVM，以保持客户端轻量。
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace tcc {
+
+// One tcc-check invocation / 一次 tcc-check 调用
+struct CheckRequest {
+    std::string workingDirectory;    // Client cwd / 客户端工作目录
+    std::vector<std::string> args;   // argv without argv[0] / 不含 argv[0] 的 argv
+};
+
+// Result of an invocation / 调用结果
+struct CheckResponse {
+    int exitCode = 0;                // tcc-check exit code / tcc-check 退出码
+    std::string out;                 // stdout text / 标准输出文本
+    std::string err;                 // stderr text / 标准错误文本
+};
+
+// Socket path: $TCC_CHECKD_SOCKET, else $XDG_RUNTIME_DIR/tcc-checkd.sock,
+// else /tmp/tcc-checkd-<uid>.sock
+// 套接字路径：$TCC_CHECKD_SOCKET，否则 $XDG_RUNTIME_DIR/tcc-checkd.sock，
+// 否则 /tmp/tcc-checkd-<uid>.sock
+std::string getDaemonSocketPath();
+
+// Messages are sequences of length-prefixed frames; false on I/O error
+// 消息由长度前缀帧组成；I/O 错误时返回 false
+bool writeRequest(int fd, const CheckRequest& request);
+bool readRequest(int fd, CheckRequest& request);
+bool writeResponse(int fd, const CheckResponse& response);
+bool readResponse(int fd, CheckResponse& response);
+
+} // namespace tcc
@@ -7,84 +7,298 @@
 #pragma once
 
 #include "tcc/Core.h"
+#include "tcc/MessageCatalog.h"
+#include "tcc/StringPool.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <unordered_set>
 #include <vector>
 
+namespace llvm {
+class raw_ostream;
+}
+
 namespace tcc {
 
-// Source location / 源码位置
+class Baseline;
+
+// Source location; the file name is interned / 源码位置；文件名经过驻留
+// Rules report unresolved locations holding raw Clang locations of the
+// current TU; LocationResolver turns them into file, line and column.
+// 规则报告未解析的位置，其中保存当前翻译单元的原始 Clang 位置；由 LocationResolver 转为文件、行和列。
 struct SourceLocation {
-    std::string filename;      // File path / 文件路径
+    StringId file;             // Interned file path / 驻留的文件路径
     unsigned line;             // Line number (1-based) / 行号（从1开始）
     unsigned column;           // Column number (1-based) / 列号（从1开始）
     
-    SourceLocation() : line(0), column(0) {}
-    SourceLocation(std::string file, unsigned l, unsigned c)
-        : filename(std::move(file)), line(l), column(c) {}
+    // `file` of unresolved locations / 未解析位置的 `file`
+    static constexpr StringId UNRESOLVED = ~StringId(0);
+    
+    SourceLocation() : file(StringPool::global().intern("")), line(0), column(0) {}
+    SourceLocation(std::string_view filename, unsigned l, unsigned c)
+        : file(StringPool::global().intern(filename)), line(l), column(c) {}
+    SourceLocation(StringId f, unsigned l, unsigned c) : file(f), line(l), column(c) {}
+    
+    // Raw location in `line`; macro locations are split into expansion and
+    // spelling only when resolved, so reporting never touches the SourceManager
+    // 原始位置保存在 `line` 中；宏位置仅在解析时才拆分为展开位置和拼写位置，因此报告时从不访问 SourceManager
+    static SourceLocation unresolved(uint32_t rawLocation) {
+        return SourceLocation(UNRESOLVED, rawLocation, 0);
+    }
+    
+    bool isResolved() const { return file != UNRESOLVED; }
+    
+    // File path, empty while unresolved / 文件路径，未解析时为空
+    const std::string& getFilename() const;
+};
+
+// Resolves raw Clang locations while their SourceManager is alive
+// 在 SourceManager 存活期间解析原始 Clang 位置
+class LocationResolver {
+public:
+    virtual ~LocationResolver() = default;
+    
+    // Presumed location of a raw location, empty if invalid / 原始位置的推定位置，无效时为空
+    virtual SourceLocation resolve(uint32_t rawLocation) = 0;
+    
+    // Raw spelling location inside a macro expansion, else `rawLocation`
+    // 宏展开内的原始拼写位置，否则为 `rawLocation`
+    virtual uint32_t getSpelling(uint32_t rawLocation) { return rawLocation; }
 };
 
 // Diagnostic message / 诊断消息
+// A compact record: text, hints and opt-outs come from the message catalog
+// and are only rendered when output is written.
+// 紧凑记录：文本、建议和退出选项来自消息目录，仅在写出时渲染。
 class Diagnostic {
 public:
-    Diagnostic(Severity severity, 
-               std::string message,
+    static constexpr size_t MAX_ARGUMENTS = 2;
+    
+    Diagnostic(Severity severity,
+               MessageId message,
+               SourceLocation location,
+               RuleCategory category,
+               std::string_view ruleId,
+               const std::vector<std::string_view>& arguments = {});
+    
+    // From strings already in the global pool / 由已在全局池中的字符串构造
+    Diagnostic(Severity severity,
+               MessageId message,
                SourceLocation location,
                RuleCategory category,
-               std::string ruleId);
+               StringId ruleId,
+               const StringId* arguments,
+               size_t argumentCount);
     
     // Accessors / 访问器
     Severity getSeverity() const { return severity_; }
-    const std::string& getMessage() const { return message_; }
+    MessageId getMessageId() const { return message_; }
     const SourceLocation& getLocation() const { return location_; }
     RuleCategory getCategory() const { return category_; }
-    const std::string& getRuleId() const { return ruleId_; }
+    const std::string& getRuleId() const { return StringPool::global().get(ruleId_); }
+    StringId getRuleIdHandle() const { return ruleId_; }
+    
+    // Replace an unresolved location / 替换未解析的位置
+    void setLocation(const SourceLocation& location) { location_ = location; }
     
-    // Add suggestion for fixing / 添加修复建议
-    void addFixHint(std::string hint);
-    const std::vector<std::string>& getFixHints() const { return fixHints_; }
+    // Message arguments such as function names / 消息参数，如函数名
+    std::vector<std::string_view> getArguments() const;
     
-    // Add escape path suggestion / 添加逃生路径建议
-    void addEscapePath(std::string escape);
-    const std::vector<std::string>& getEscapePaths() const { return escapePaths_; }
+    // Text in the given locale / 指定语言的文本
+    std::string getMessage(Locale locale = Locale::Bilingual) const;
+    void appendMessage(std::string& out, Locale locale) const;
+    std::vector<std::string> getFixHints(Locale locale = Locale::Bilingual) const;
+    std::vector<std::string> getEscapePaths(Locale locale = Locale::Bilingual) const;
     
     // Format for output / 格式化输出
-    std::string format() const;
+    std::string format(Locale locale = Locale::Bilingual) const;
 
 private:
-    Severity severity_;
-    std::string message_;
     SourceLocation location_;
+    StringId ruleId_;
+    std::array<StringId, MAX_ARGUMENTS> arguments_{};
+    MessageId message_;
+    Severity severity_;
     RuleCategory category_;
-    std::string ruleId_;
-    std::vector<std::string> fixHints_;      // How to fix / 如何修复
-    std::vector<std::string> escapePaths_;   // How to opt-out / 如何退出
+    uint8_t argumentCount_ = 0;
+};
+
+// Receives diagnostics as they are flushed / 在诊断刷出时接收诊断
+class DiagnosticSink {
+public:
+    virtual ~DiagnosticSink() = default;
+    
+    // Handle one diagnostic / 处理一条诊断
+    virtual void handle(const Diagnostic& diag) = 0;
+    
+    // No more diagnostics follow; close any open structure
+    // 之后不再有诊断；关闭所有未闭合的结构
+    virtual void finish() {}
+};
+
+// Writes the human-readable format / 写出人类可读格式
+class TextDiagnosticSink : public DiagnosticSink {
+public:
+    explicit TextDiagnosticSink(llvm::raw_ostream& os, Locale locale = Locale::Bilingual)
+        : os_(os), locale_(locale) {}
+    
+    void handle(const Diagnostic& diag) override;
+
+private:
+    llvm::raw_ostream& os_;
+    Locale locale_;
+};
+
+// Forwards every diagnostic to several sinks / 将每条诊断转发给多个接收器
+class TeeDiagnosticSink : public DiagnosticSink {
+public:
+    explicit TeeDiagnosticSink(std::vector<DiagnosticSink*> sinks) : sinks_(std::move(sinks)) {}
+    
+    void handle(const Diagnostic& diag) override {
+        for (auto* sink : sinks_) {
+            sink->handle(diag);
+        }
+    }
+    
+    void finish() override {
+        for (auto* sink : sinks_) {
+            sink->finish();
+        }
+    }
+
+private:
+    std::vector<DiagnosticSink*> sinks_;
+};
+
+// Identity used to drop repeated reports: rule plus expansion and spelling
+// location / 用于丢弃重复报告的标识：规则加展开位置和拼写位置
+struct DiagnosticKey {
+    StringId ruleId;
+    SourceLocation expansion;   // Where the diagnostic is shown / 诊断显示的位置
+    SourceLocation spelling;    // Where the text was written / 文本书写的位置
+    
+    bool operator==(const DiagnosticKey& other) const;
+};
+
+struct DiagnosticKeyHash {
+    size_t operator()(const DiagnosticKey& key) const;
+};
+
+// Keys seen by earlier TUs of a run; safe to share between workers
+// 本次运行中前面的翻译单元已见过的键；可在工作线程间共享
+class DiagnosticDeduplicator {
+public:
+    // True the first time the key of `diag` is seen / 首次见到 `diag` 的键时返回 true
+    bool insert(const Diagnostic& diag);
+
+private:
+    std::mutex mutex_;
+    std::unordered_set<DiagnosticKey, DiagnosticKeyHash> seen_;
 };
 
 // Diagnostic collector / 诊断收集器
+// Repeats at the same rule and location are dropped on report.
+// 同一规则和位置的重复报告在报告时即被丢弃。
+// Severity counts are kept on report, so they survive flush() and all
+// count queries are O(1).
+// 严重程度计数在报告时维护，因此在 flush() 之后仍然保留，所有计数查询均为 O(1)。
 class DiagnosticEngine {
 public:
     DiagnosticEngine() = default;
     
-    // Add diagnostic / 添加诊断
+    // Add diagnostic unless already reported; `spelling` defaults to the
+    // diagnostic's own location / 添加诊断（若未报告过）；`spelling` 默认为诊断自身的位置
     void report(Diagnostic diag);
+    void report(Diagnostic diag, const SourceLocation& spelling);
+    
+    // Move all diagnostics of another engine to the end of this one
+    // 将另一个引擎的所有诊断移到此引擎末尾
+    void append(DiagnosticEngine&& other);
+    
+    // Resolve locations through `resolver` until resolveLocations()
+    // 在 resolveLocations() 之前通过 `resolver` 解析位置
+    void attachResolver(LocationResolver* resolver) { resolver_ = resolver; }
+    
+    // Null when none is attached / 未附加时为空
+    LocationResolver* getResolver() const { return resolver_; }
+    
+    // Resolve every pending location, dropping reports that turn out to be
+    // repeats, and detach the resolver / 解析所有待定位置，丢弃解析后重复的报告，并分离解析器
+    void resolveLocations();
+    
+    // Order stored diagnostics by file, line, column and rule, so output
+    // does not depend on the order rules ran in
+    // 按文件、行、列和规则对已存储的诊断排序，使输出不依赖规则的运行顺序
+    void sortByLocation();
+    
+    // Cancel `token` as soon as an error is reported or appended, null = never.
+    // Errors in `baseline` do not count.
+    // 一旦报告或追加了错误即取消 `token`，空 = 从不。`baseline` 中的错误不计入。
+    void cancelOnError(CancellationToken* token, const Baseline* baseline = nullptr) {
+        cancelOnError_ = token;
+        baseline_ = baseline;
+    }
     
-    // Query diagnostics / 查询诊断
+    // Cancel on the same errors as `parent`, resolving through `resolver`;
+    // for an engine collecting part of the parent's TU on another thread
+    // 与 `parent` 在相同的错误上取消，并通过 `resolver` 解析；用于在其他线程上收集父引擎翻译单元一部分的引擎
+    void shareCancellation(const DiagnosticEngine& parent, LocationResolver* resolver) {
+        cancelOnError_ = parent.cancelOnError_;
+        baseline_ = parent.baseline_;
+        resolver_ = resolver;
+    }
+    
+    // Diagnostics not yet flushed / 尚未刷出的诊断
     const std::vector<Diagnostic>& getDiagnostics() const { return diagnostics_; }
     
     // Check if any errors / 检查是否有错误
-    bool hasErrors() const;
+    bool hasErrors() const { return getErrorCount() > 0; }
     
     // Get error count / 获取错误数量
-    size_t getErrorCount() const;
+    size_t getErrorCount() const { return getCount(Severity::Error); }
+    
+    // Diagnostics of one severity reported so far / 到目前为止报告的某一严重程度的诊断数
+    size_t getCount(Severity severity) const {
+        return counts_[static_cast<size_t>(severity)];
+    }
+    
+    // All diagnostics reported so far, flushed or not / 到目前为止报告的全部诊断，无论是否已刷出
+    size_t getDiagnosticCount() const;
     
     // Print all diagnostics / 打印所有诊断
-    void printAll(std::ostream& os) const;
+    void printAll(llvm::raw_ostream& os, Locale locale = Locale::Bilingual) const;
+    
+    // Hand the stored diagnostics to `sink` and release them with their
+    // keys; counts are kept / 将存储的诊断交给 `sink` 并连同其键一起释放；计数保留
+    void flush(DiagnosticSink& sink);
     
-    // Clear all / 清空
+    // Drop stored diagnostics another TU already produced / 丢弃其他翻译单元已产生的已存储诊断
+    void removeDuplicates(DiagnosticDeduplicator& seen);
+    
+    // Drop stored diagnostics matching `predicate`, with their counts;
+    // returns how many were dropped
+    // 丢弃匹配 `predicate` 的已存储诊断及其计数；返回丢弃的数量
+    size_t removeIf(const std::function<bool(const Diagnostic&)>& predicate);
+    
+    // Clear all, including counts / 清空全部，包括计数
     void clear();
 
 private:
     std::vector<Diagnostic> diagnostics_;
+    std::unordered_set<DiagnosticKey, DiagnosticKeyHash> reported_;   // This TU / 本翻译单元
+    std::array<size_t, 3> counts_{};   // Indexed by Severity / 按 Severity 索引
+    CancellationToken* cancelOnError_ = nullptr;   // Set by --fail-fast / 由 --fail-fast 设置
+    const Baseline* baseline_ = nullptr;           // Errors not cancelling / 不触发取消的错误
+    LocationResolver* resolver_ = nullptr;         // Current TU / 当前翻译单元
+    
+    // Cancel on `diag` if it is a new error / 若 `diag` 是新错误则取消
+    void checkCancel(const Diagnostic& diag) const;
 };
 
 } // namespace tcc
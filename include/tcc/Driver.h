@@ -0,0 +1,122 @@
+﻿// Tough C Profiler - Analysis Driver
+// Tough C 分析器 - 分析驱动
+//
+// Runs the rule engine over a batch of translation units
+// 在一批翻译单元上运行规则引擎
+
+#pragma once
+
+#include "tcc/ApiCatalog.h"
+#include "tcc/Baseline.h"
+#include "tcc/Core.h"
+#include "tcc/Diagnostic.h"
+#include "tcc/FileDetector.h"
+#include "tcc/ResultCache.h"
+#include "tcc/RuleEngine.h"
+#include "tcc/SharedPCH.h"
+#include "tcc/TimeReport.h"
+
+#include <clang/Tooling/CompilationDatabase.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace tcc {
+
+// Options for a batch run / 批量运行选项
+struct DriverOptions {
+    unsigned jobs = 1;              // Worker threads, 0 = all cores / 工作线程数，0 = 所有核心
+    unsigned tuThreads = 1;         // Rule-check threads per parsed TU / 每个已解析翻译单元的规则检查线程数
+    bool verbose = false;           // Verbose output / 详细输出
+    bool ownershipChecks = true;    // Check ownership rules / 检查所有权规则
+    bool lifetimeChecks = true;     // Check lifetime rules / 检查生命周期规则
+    bool concurrencyChecks = true;  // Check concurrency rules / 检查并发规则
+    std::string cacheDirectory;     // Result cache, empty = disabled / 结果缓存，空 = 禁用
+    uint64_t cacheMaxBytes = 512ull << 20;  // Cache size cap / 缓存大小上限
+    bool sharedPCH = false;         // Shared prefix PCH in the cache / 缓存中的共享前缀 PCH
+    bool recordDependencies = false; // Fill TUResult::dependencies / 填充 TUResult::dependencies
+    TimeReport* timeReport = nullptr;    // Phase and rule costs, null = off / 阶段和规则开销，空 = 关闭
+    bool failFast = false;          // Stop everything at the first error / 遇到第一个错误即全部停止
+    bool gate = false;              // Skip expensive rules in rejected TUs / 对已拒绝的翻译单元跳过昂贵规则
+    const Baseline* baseline = nullptr;  // Accepted violations, null = none / 已接受的违规，空 = 无
+    const ApiCatalog* apiCatalog = nullptr;  // Allocation APIs, null = built-in / 分配 API，空 = 内置
+    std::vector<const RulePlugin*> plugins;  // Rule libraries from --load / 来自 --load 的规则库
+    CancellationToken* cancel = nullptr;     // Stops the run from outside, null = none / 从外部停止运行，空 = 无
+};
+
+// Result of checking one translation unit / 单个翻译单元的检查结果
+struct TUResult {
+    std::string file;                // Source path / 源文件路径
+    DiagnosticEngine diagnostics;    // Diagnostics of this TU only / 仅此翻译单元的诊断
+    std::optional<TCCConfig> config; // Unset if the file is not TCC / 非 TCC 文件时为空
+    std::string compilerOutput;      // Clang's own diagnostics / Clang 自身的诊断
+    std::vector<std::string> dependencies;  // Non-system files read / 读取的非系统文件
+    int toolStatus = 0;              // ClangTool::run status / ClangTool::run 状态
+    bool cacheHit = false;           // Replayed from the result cache / 从结果缓存回放
+    bool cancelled = false;          // Cut short or skipped by --fail-fast / 被 --fail-fast 截断或跳过
+    size_t baselined = 0;            // Dropped as accepted by the baseline / 因基线已接受而丢弃
+};
+
+// Batch driver / 批量驱动
+class Driver {
+public:
+    // Progress goes to `log` / 进度输出到 `log`
+    Driver(const clang::tooling::CompilationDatabase& compilations,
+           DriverOptions options,
+           llvm::raw_ostream& log);
+    
+    // Called once per file in input order, as soon as it and every earlier
+    // file are done, one call at a time
+    // 按输入顺序对每个文件调用一次，在该文件及之前所有文件完成后立即调用，调用互不重叠
+    using ResultCallback = std::function<void(TUResult&)>;
+    
+    // Check all files; results and their deduplication follow input order
+    // regardless of -j. `onResult` may flush each result it sees.
+    // With failFast, files not started before the first error are skipped.
+    // 检查所有文件；无论 -j 为何值，结果及其去重均按输入顺序进行。
+    // `onResult` 可将收到的每个结果刷出。
+    // 启用 failFast 时，在第一个错误之前未开始的文件将被跳过。
+    std::vector<TUResult> run(const std::vector<std::string>& files,
+                              const ResultCallback& onResult = nullptr);
+    
+    // Rule engine configured from the options / 按选项配置的规则引擎
+    static std::unique_ptr<RuleEngine> createEngine(const DriverOptions& options);
+
+private:
+    // Run `worker` on up to workerCount threads / 在最多 workerCount 个线程上运行 `worker`
+    static void runWorkers(unsigned workerCount, const std::function<void()>& worker);
+    
+    // Resolve the file's TCC config / 解析文件的 TCC 配置
+    void gateFile(TUResult& result);
+    
+    // Check a single file / 检查单个文件
+    void checkFile(RuleEngine& engine, TUResult& result, CancellationToken& cancel);
+    
+    // Run the frontend, optionally on top of a PCH; returns the tool status.
+    // `pchFailed` is set if the PCH could not be loaded.
+    // 运行前端，可选地基于 PCH；返回工具状态。PCH 无法加载时设置 `pchFailed`。
+    int runFrontend(RuleEngine& engine, TUResult& result, CategoryMask categories,
+                    const std::string& pch, const CancellationToken& cancel,
+                    bool* pchFailed = nullptr);
+    
+    // Add to the time report when enabled / 启用时加入时间报告
+    void recordPhase(const char* phase, const Stopwatch& stopwatch);
+    
+    unsigned getWorkerCount(size_t fileCount) const;
+    
+    const clang::tooling::CompilationDatabase& compilations_;
+    DriverOptions options_;
+    llvm::raw_ostream& log_;
+    std::unique_ptr<ResultCache> cache_;
+    std::unique_ptr<SharedPCH> pch_;
+    std::mutex outputMutex_;   // Serializes verbose output / 串行化详细输出
+    std::mutex resultMutex_;   // Serializes releasing results / 串行化结果的发布
+};
+
+} // namespace tcc
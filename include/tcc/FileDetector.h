@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <istream>
 #include <string>
 #include <optional>
 
@@ -28,14 +29,24 @@ public:
     static bool shouldAnalyze(const std::string& filename);
     
     // Parse TCC configuration from file / 从文件解析 TCC 配置
+    // Opens the file once. Files that do not opt in cost at most the marker
+    // lines and get nullopt; only the others are read to the end.
+    // 只打开文件一次。未启用 TCC 的文件最多读取标记所在的行并返回 nullopt；只有其他文件才读到末尾。
     static std::optional<TCCConfig> parseConfig(const std::string& filename);
     
 private:
+    // Lines searched for the @tcc marker / 查找 @tcc 标记的行数
+    static constexpr int ANNOTATION_LINES = 100;
+    
     // Check file extension / 检查文件扩展名
     static bool hasTCCExtension(const std::string& filename);
     
-    // Check for annotation in file / 检查文件中的注解
-    static bool hasTCCAnnotation(const std::string& filename);
+    // Check for the annotation in the first ANNOTATION_LINES lines
+    // 在前 ANNOTATION_LINES 行中检查注解
+    static bool hasTCCAnnotation(const std::string& prefix);
+    
+    // Read up to `count` lines, keeping their newlines / 读取最多 `count` 行，保留换行符
+    static std::string readLines(std::istream& input, int count);
     
     // Parse annotation config / 解析注解配置
     static TCCConfig parseAnnotation(const std::string& content);
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include "tcc/MatcherRule.h"
 #include "tcc/Rule.h"
 #include <clang/AST/Decl.h>
 #include <clang/AST/Stmt.h>
@@ -15,14 +16,14 @@ namespace tcc {
 
 // Rule: Forbid returning reference to local variable
 // 规则：禁止返回局部变量的引用
-class ForbidDanglingRefRule : public LifetimeRule {
+class ForbidDanglingRefRule
+    : public NodeRule<ForbidDanglingRefRule, LifetimeRule, NodeKind::ReturnStmt> {
 public:
     ForbidDanglingRefRule()
-        : LifetimeRule("TCC-LIFE-001",
-                      "Returning reference to local variable / "
-                      "返回局部变量的引用") {}
-    
-    void check(clang::ASTContext& context, DiagnosticEngine& diagnostics) override;
+        : NodeRule("TCC-LIFE-001",
+                  "Returning reference to local variable / "
+                  "返回局部变量的引用",
+                  RuleCost::Moderate) {}
     
     // Check specific return statement / 检查特定的 return 语句
     void checkReturnStmt(clang::ReturnStmt* stmt,
@@ -33,14 +34,14 @@ public:
 
 // Rule: Forbid returning pointer to local variable
 // 规则：禁止返回局部变量的指针
-class ForbidDanglingPtrRule : public LifetimeRule {
+class ForbidDanglingPtrRule
+    : public NodeRule<ForbidDanglingPtrRule, LifetimeRule, NodeKind::ReturnStmt> {
 public:
     ForbidDanglingPtrRule()
-        : LifetimeRule("TCC-LIFE-002",
-                      "Returning pointer to local variable / "
-                      "返回局部变量的指针") {}
-    
-    void check(clang::ASTContext& context, DiagnosticEngine& diagnostics) override;
+        : NodeRule("TCC-LIFE-002",
+                  "Returning pointer to local variable / "
+                  "返回局部变量的指针",
+                  RuleCost::Moderate) {}
     
     // Check specific return statement / 检查特定的 return 语句
     void checkReturnStmt(clang::ReturnStmt* stmt,
@@ -51,30 +52,40 @@ public:
 
 // Rule: Forbid containers storing raw pointers
 // 规则：禁止容器存储原始指针
-class ForbidRawPtrContainerRule : public LifetimeRule {
+class ForbidRawPtrContainerRule
+    : public MatcherRule<ForbidRawPtrContainerRule, LifetimeRule,
+                         NodeKind::VarDecl, NodeKind::FieldDecl> {
 public:
     ForbidRawPtrContainerRule()
-        : LifetimeRule("TCC-LIFE-003",
-                      "Container storing raw pointers / "
-                      "容器存储原始指针") {}
-    
-    void check(clang::ASTContext& context, DiagnosticEngine& diagnostics) override;
+        : MatcherRule("TCC-LIFE-003",
+                     "Container storing raw pointers / "
+                     "容器存储原始指针",
+                     RuleCost::Moderate) {}
     
-    // Check if type is a container of raw pointers
-    // 检查类型是否是原始指针的容器
-    bool isRawPointerContainer(clang::QualType type) const;
+    // Match variables and fields of type std::vector<T*>, std::set<T*>, ...
+    // 匹配类型为 std::vector<T*>、std::set<T*> 等的变量和字段
+    void registerMatchers(clang::ast_matchers::MatchFinder& finder,
+                          clang::ast_matchers::MatchFinder::MatchCallback* callback);
+    void onMatch(const clang::ast_matchers::MatchFinder::MatchResult& result,
+                 const NodeHookContext& hook);
 };
 
 // Rule: Forbid reference members without clear lifetime
 // 规则：禁止没有明确生命周期的引用成员
-class ForbidUntrackedRefMemberRule : public LifetimeRule {
+class ForbidUntrackedRefMemberRule
+    : public MatcherRule<ForbidUntrackedRefMemberRule, LifetimeRule, NodeKind::CXXRecordDecl> {
 public:
     ForbidUntrackedRefMemberRule()
-        : LifetimeRule("TCC-LIFE-004",
-                      "Reference member without clear lifetime / "
-                      "没有明确生命周期的引用成员") {}
+        : MatcherRule("TCC-LIFE-004",
+                     "Reference member without clear lifetime / "
+                     "没有明确生命周期的引用成员",
+                     RuleCost::Moderate) {}
     
-    void check(clang::ASTContext& context, DiagnosticEngine& diagnostics) override;
+    // Match each reference field of a class definition / 匹配类定义中的每个引用字段
+    void registerMatchers(clang::ast_matchers::MatchFinder& finder,
+                          clang::ast_matchers::MatchFinder::MatchCallback* callback);
+    void onMatch(const clang::ast_matchers::MatchFinder::MatchResult& result,
+                 const NodeHookContext& hook);
 };
 
 } // namespace tcc
@@ -0,0 +1,106 @@
+﻿// Tough C Profiler - Matcher Rules
+// Tough C 分析器 - 匹配器规则
+//
+// Rules written as Clang AST matchers, sharing one MatchFinder
+// 以 Clang AST 匹配器编写、共享同一个 MatchFinder 的规则
+
+#pragma once
+
+#include "tcc/Diagnostic.h"
+#include "tcc/Rule.h"
+
+#include <clang/ASTMatchers/ASTMatchFinder.h>
+#include <clang/ASTMatchers/ASTMatchers.h>
+
+#include <memory>
+#include <vector>
+
+namespace tcc {
+
+// Matchers of every MatcherRule in a dispatch table / 分发表中所有 MatcherRule 的匹配器
+// All matcher rules share one pass over the traversal scope. The pass
+// keeps one matcher visitor, and with it the memo cache of descendant
+// and ancestor matches, for the whole TU; matching node by node would
+// rebuild both for every node.
+// 所有匹配器规则共享一次对遍历范围的扫描。该扫描在整个翻译单元中保持同一个匹配器访问者，
+// 以及其后代和祖先匹配的记忆化缓存；逐节点匹配会为每个节点重建两者。
+class RuleMatchFinder {
+public:
+    using MatchResult = clang::ast_matchers::MatchFinder::MatchResult;
+    using MatchCallback = clang::ast_matchers::MatchFinder::MatchCallback;
+    using MatchHandler = void (*)(Rule* rule, const MatchResult& result,
+                                  const NodeHookContext& hook);
+    
+    // Route matches of the returned callback to `handler`
+    // 将返回的回调的匹配结果交给 `handler`
+    MatchCallback* addRule(Rule* rule, MatchHandler handler, RuleStats* stats);
+    
+    clang::ast_matchers::MatchFinder& getFinder() { return finder_; }
+    
+    // Run every matcher over the traversal scope of `hook.context` in one
+    // pass; matches found once `cancel` is set are dropped
+    // 在一次扫描中对 `hook.context` 的遍历范围运行所有匹配器；`cancel` 被设置后找到的匹配被丢弃
+    void matchAST(const NodeHookContext& hook, const CancellationToken& cancel);
+
+private:
+    class Callback : public MatchCallback {
+    public:
+        Callback(RuleMatchFinder& owner, Rule* rule, MatchHandler handler, RuleStats* stats)
+            : owner_(owner), rule_(rule), handler_(handler), stats_(stats) {}
+        
+        void run(const MatchResult& result) override;
+    
+    private:
+        RuleMatchFinder& owner_;
+        Rule* rule_;
+        MatchHandler handler_;
+        RuleStats* stats_;    // Profiling slot, null when not profiling / 分析槽，不分析时为空
+    };
+    
+    clang::ast_matchers::MatchFinder finder_;
+    std::vector<std::unique_ptr<Callback>> callbacks_;
+    const NodeHookContext* hook_ = nullptr;        // Set only inside matchAST() / 仅在 matchAST() 中设置
+    const CancellationToken* cancel_ = nullptr;    // Set only inside matchAST() / 仅在 matchAST() 中设置
+};
+
+// Base of rules written as AST matchers / 以 AST 匹配器编写的规则基类
+// `Kinds` lists the node kinds the matchers are rooted at. Derived declares
+//   void registerMatchers(MatchFinder& finder, MatchFinder::MatchCallback* callback);
+//   void onMatch(const MatchFinder::MatchResult& result, const NodeHookContext& hook);
+// adding each matcher with `callback`. Only nodes inside the main-file
+// top-level declarations are matched, and `hook.function` is null.
+// registerMatchers runs once per traversal, before any match, so it may
+// also reset per-TU state. The matcher pass of a sharded TU runs on one
+// thread while the node rules run on the others: handlers must only read
+// the AST.
+// `Kinds` 列出匹配器的根节点类型。Derived 声明上述两个成员，并以 `callback` 添加每个匹配器。
+// 只匹配主文件顶层声明内的节点，且 `hook.function` 为空。registerMatchers 在每次遍历的
+// 任何匹配之前运行一次，因此也可在其中重置每个翻译单元的状态。分片的翻译单元的匹配器扫描
+// 在一个线程上运行，节点规则在其他线程上运行：处理函数只能读取 AST。
+template <typename Derived, typename Base, NodeKind... Kinds>
+class MatcherRule : public Base {
+    static_assert(sizeof...(Kinds) > 0, "MatcherRule needs at least one node kind");
+
+public:
+    using Base::Base;
+    
+    NodeMask getNodeInterests() const final { return (nodeBit(Kinds) | ...); }
+    
+    void subscribe(RuleDispatchTable& table, RuleStats* stats) final {
+        auto& matchers = table.getOrCreateMatchFinder();
+        auto* callback = matchers.addRule(this, &dispatch, stats);
+        static_cast<Derived*>(this)->registerMatchers(matchers.getFinder(), callback);
+    }
+    
+    std::unique_ptr<Rule> clone() const final {
+        return std::make_unique<Derived>(static_cast<const Derived&>(*this));
+    }
+
+private:
+    static void dispatch(Rule* rule, const RuleMatchFinder::MatchResult& result,
+                         const NodeHookContext& hook) {
+        static_cast<Derived*>(rule)->onMatch(result, hook);
+    }
+};
+
+} // namespace tcc
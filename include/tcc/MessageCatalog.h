@@ -0,0 +1,69 @@
+﻿// Tough C Profiler - Message Catalog
+// Tough C 分析器 - 消息目录
+//
+// Text of every diagnostic, resolved to a locale only when output is written
+// 所有诊断的文本，仅在写出时才按语言环境解析
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tcc {
+
+// Output language / 输出语言
+enum class Locale : uint8_t {
+    Bilingual,  // "English / 中文" (default) / 双语（默认）
+    English,    // English only / 仅英文
+    Chinese     // Chinese only / 仅中文
+};
+
+// Catalog entry of a diagnostic / 诊断的目录条目
+enum class MessageId : uint16_t {
+    ForbidNew,                  // TCC-OWN-001
+    ForbidDelete,               // TCC-OWN-002
+    ForbidAllocation,           // TCC-OWN-003 malloc/calloc/realloc
+    ForbidDeallocation,         // TCC-OWN-003 free
+    RawOwningReturn,            // TCC-OWN-004
+    DanglingReference,          // TCC-LIFE-001
+    DanglingPointer,            // TCC-LIFE-002
+    RawPointerContainer,        // TCC-LIFE-003
+    UntrackedReferenceMember,   // TCC-LIFE-004
+    UnsyncSharedState,          // TCC-CONC-001
+    NonConstLambdaCapture,      // TCC-CONC-002
+    PluginRule,                 // Rules loaded with --load: %0 English, %1 Chinese text
+    Count
+};
+
+// One text in both languages / 一段双语文本
+struct LocalizedText {
+    const char* english;
+    const char* chinese;
+};
+
+// Message template with its fixed hints; "%0", "%1" are argument slots
+// 消息模板及其固定建议；"%0"、"%1" 为参数占位符
+struct MessageEntry {
+    LocalizedText message;
+    std::vector<LocalizedText> fixHints;      // How to fix / 如何修复
+    std::vector<LocalizedText> escapePaths;   // How to opt-out / 如何退出
+};
+
+// Built-in message catalog / 内置消息目录
+class MessageCatalog {
+public:
+    static const MessageEntry& get(MessageId id);
+    
+    // Text in the given locale with arguments substituted
+    // 以指定语言输出文本并替换参数
+    static std::string render(const LocalizedText& text, Locale locale,
+                              const std::vector<std::string_view>& arguments = {});
+    
+    // Same, appended to `out` without temporaries / 同上，直接追加到 `out`，不产生临时对象
+    static void renderTo(std::string& out, const LocalizedText& text, Locale locale,
+                         const std::string_view* arguments = nullptr, size_t argumentCount = 0);
+};
+
+} // namespace tcc
@@ -0,0 +1,101 @@
+﻿// Tough C Profiler - Machine-Readable Output
+// Tough C 分析器 - 机器可读输出
+//
+// SARIF and JSON Lines writers for review bots and CI
+// 面向代码审查机器人和 CI 的 SARIF 与 JSON Lines 写出器
+
+#pragma once
+
+#include "tcc/Diagnostic.h"
+
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+
+namespace llvm {
+class raw_ostream;
+}
+
+namespace tcc {
+
+// Output format of tcc-check / tcc-check 的输出格式
+enum class OutputFormat {
+    Text,       // Human-readable (default) / 人类可读（默认）
+    SARIF,      // SARIF 2.1.0 log / SARIF 2.1.0 日志
+    JSONLines   // One JSON object per diagnostic / 每条诊断一个 JSON 对象
+};
+
+// JSON serialized into one reusable buffer, written out once per record
+// 序列化到一个可复用的缓冲区中，每条记录写出一次
+class JSONBuffer {
+public:
+    void beginObject() { separate(); buffer_ += '{'; first_ = true; }
+    void endObject() { buffer_ += '}'; first_ = false; }
+    void beginArray() { separate(); buffer_ += '['; first_ = true; }
+    void endArray() { buffer_ += ']'; first_ = false; }
+    
+    // Object key; the next value belongs to it / 对象键；下一个值属于它
+    void key(std::string_view name);
+    
+    void value(std::string_view text);
+    void value(unsigned number);
+    
+    // Catalog text rendered straight into the buffer / 目录文本直接渲染到缓冲区
+    void value(const LocalizedText& text, Locale locale);
+    void message(const Diagnostic& diag, Locale locale);
+    
+    // Raw JSON, e.g. a newline between records / 原始 JSON，例如记录之间的换行
+    void raw(std::string_view json) { buffer_ += json; }
+    
+    // Write and reset, keeping the capacity / 写出并重置，保留容量
+    void flushTo(llvm::raw_ostream& os);
+
+private:
+    void separate();
+    void appendEscaped(std::string_view text);
+    
+    std::string buffer_;
+    std::string scratch_;   // Rendered text before escaping / 转义前的渲染文本
+    bool first_ = true;     // No value yet in the open container / 当前容器中尚无值
+    bool afterKey_ = false;
+};
+
+// One JSON object per line / 每行一个 JSON 对象
+class JSONLinesSink : public DiagnosticSink {
+public:
+    JSONLinesSink(llvm::raw_ostream& os, Locale locale) : os_(os), locale_(locale) {}
+    
+    void handle(const Diagnostic& diag) override;
+
+private:
+    llvm::raw_ostream& os_;
+    Locale locale_;
+    JSONBuffer json_;
+};
+
+// SARIF 2.1.0 log with a single run; results are streamed, the rule table
+// follows them and is written by finish()
+// 含单个运行的 SARIF 2.1.0 日志；结果按流写出，规则表位于其后由 finish() 写出
+class SARIFSink : public DiagnosticSink {
+public:
+    SARIFSink(llvm::raw_ostream& os, Locale locale);
+    
+    void handle(const Diagnostic& diag) override;
+    void finish() override;
+
+private:
+    llvm::raw_ostream& os_;
+    Locale locale_;
+    JSONBuffer json_;
+    bool firstResult_ = true;
+    bool finished_ = false;
+    std::set<std::string> ruleIds_;   // Rules seen, for tool.driver.rules / 出现过的规则
+};
+
+// Sink writing diagnostics in `format` / 以 `format` 格式写出诊断的接收器
+std::unique_ptr<DiagnosticSink> createOutputSink(OutputFormat format,
+                                                 llvm::raw_ostream& os,
+                                                 Locale locale);
+
+} // namespace tcc
@@ -6,64 +6,84 @@
 
 #pragma once
 
+#include "tcc/ApiCatalog.h"
+#include "tcc/MatcherRule.h"
 #include "tcc/Rule.h"
 #include <clang/AST/Expr.h>
 #include <clang/AST/Decl.h>
+#include <optional>
 
 namespace tcc {
 
 // Rule: Forbid 'new' operator / 规则：禁止 'new' 操作符
-class ForbidNewRule : public OwnershipRule {
+class ForbidNewRule
+    : public MatcherRule<ForbidNewRule, OwnershipRule, NodeKind::CXXNewExpr> {
 public:
     ForbidNewRule()
-        : OwnershipRule("TCC-OWN-001", 
-                       "Use of 'new' operator forbidden / 禁止使用 'new' 操作符") {}
+        : MatcherRule("TCC-OWN-001", 
+                     "Use of 'new' operator forbidden / 禁止使用 'new' 操作符") {}
     
-    void check(clang::ASTContext& context, DiagnosticEngine& diagnostics) override;
-    
-    // Check specific new expression / 检查特定的 new 表达式
-    void checkNewExpr(clang::CXXNewExpr* expr,
-                     clang::ASTContext& context,
-                     DiagnosticEngine& diagnostics);
+    // Match every new expression / 匹配所有 new 表达式
+    void registerMatchers(clang::ast_matchers::MatchFinder& finder,
+                          clang::ast_matchers::MatchFinder::MatchCallback* callback);
+    void onMatch(const clang::ast_matchers::MatchFinder::MatchResult& result,
+                 const NodeHookContext& hook);
 };
 
 // Rule: Forbid 'delete' operator / 规则：禁止 'delete' 操作符
-class ForbidDeleteRule : public OwnershipRule {
+class ForbidDeleteRule
+    : public MatcherRule<ForbidDeleteRule, OwnershipRule, NodeKind::CXXDeleteExpr> {
 public:
     ForbidDeleteRule()
-        : OwnershipRule("TCC-OWN-002",
-                       "Use of 'delete' operator forbidden / 禁止使用 'delete' 操作符") {}
-    
-    void check(clang::ASTContext& context, DiagnosticEngine& diagnostics) override;
+        : MatcherRule("TCC-OWN-002",
+                     "Use of 'delete' operator forbidden / 禁止使用 'delete' 操作符") {}
     
-    // Check specific delete expression / 检查特定的 delete 表达式
-    void checkDeleteExpr(clang::CXXDeleteExpr* expr,
-                        clang::ASTContext& context,
-                        DiagnosticEngine& diagnostics);
+    // Match every delete expression / 匹配所有 delete 表达式
+    void registerMatchers(clang::ast_matchers::MatchFinder& finder,
+                          clang::ast_matchers::MatchFinder::MatchCallback* callback);
+    void onMatch(const clang::ast_matchers::MatchFinder::MatchResult& result,
+                 const NodeHookContext& hook);
 };
 
 // Rule: Forbid malloc/free / 规则：禁止 malloc/free
-class ForbidMallocFreeRule : public OwnershipRule {
+class ForbidMallocFreeRule
+    : public MatcherRule<ForbidMallocFreeRule, OwnershipRule, NodeKind::CallExpr> {
 public:
-    ForbidMallocFreeRule()
-        : OwnershipRule("TCC-OWN-003",
-                       "Use of malloc/free forbidden / 禁止使用 malloc/free") {}
+    explicit ForbidMallocFreeRule(const ApiCatalog& catalog = ApiCatalog::builtin())
+        : MatcherRule("TCC-OWN-003",
+                     "Use of malloc/free forbidden / 禁止使用 malloc/free")
+        , catalog_(catalog) {}
     
-    void check(clang::ASTContext& context, DiagnosticEngine& diagnostics) override;
+    // Match direct calls and report those the catalog forbids
+    // 匹配直接调用并报告目录禁止的调用
+    void registerMatchers(clang::ast_matchers::MatchFinder& finder,
+                          clang::ast_matchers::MatchFinder::MatchCallback* callback);
+    void onMatch(const clang::ast_matchers::MatchFinder::MatchResult& result,
+                 const NodeHookContext& hook);
+
+private:
+    const ApiCatalog& catalog_;
+    std::optional<ApiCatalog::Lookup> lookup_;   // Compiled for the current TU / 为当前翻译单元编译
 };
 
 // Rule: Detect raw owning pointers / 规则：检测原始所有权指针
-class RawOwningPointerRule : public OwnershipRule {
+class RawOwningPointerRule
+    : public MatcherRule<RawOwningPointerRule, OwnershipRule, NodeKind::FunctionDecl> {
 public:
     RawOwningPointerRule()
-        : OwnershipRule("TCC-OWN-004",
-                       "Raw owning pointer detected / 检测到原始所有权指针") {}
+        : MatcherRule("TCC-OWN-004",
+                     "Raw owning pointer detected / 检测到原始所有权指针") {}
     
-    void check(clang::ASTContext& context, DiagnosticEngine& diagnostics) override;
+    // Match functions with a body returning a raw pointer
+    // 匹配有函数体且返回原始指针的函数
+    void registerMatchers(clang::ast_matchers::MatchFinder& finder,
+                          clang::ast_matchers::MatchFinder::MatchCallback* callback);
+    void onMatch(const clang::ast_matchers::MatchFinder::MatchResult& result,
+                 const NodeHookContext& hook);
     
-    // Check if function returns raw pointer (potential ownership)
-    // 检查函数是否返回原始指针（潜在所有权）
-    bool isOwningPointerReturn(clang::FunctionDecl* decl) const;
+    // Check if the name suggests ownership (e.g., "create", "make")
+    // 检查函数名是否暗示所有权（例如 "create"、"make"）
+    bool isOwningName(const std::string& name) const;
 };
 
 } // namespace tcc
@@ -0,0 +1,55 @@
+﻿// Tough C Profiler - Result Cache
+// Tough C 分析器 - 结果缓存
+//
+// Content-addressed on-disk cache of per-TU diagnostics
+// 按内容寻址的磁盘缓存，保存每个翻译单元的诊断
+
+#pragma once
+
+#include "tcc/Core.h"
+#include "tcc/Diagnostic.h"
+
+#include <clang/Tooling/CompilationDatabase.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tcc {
+
+// On-disk result cache / 磁盘结果缓存
+// Entries are immutable files named by their key; concurrent workers may
+// read and write the same directory.
+// 条目是以键命名的不可变文件；并发工作线程可读写同一目录。
+class ResultCache {
+public:
+    ResultCache(std::string directory, uint64_t maxBytes);
+    
+    // Cache key of a TU: preprocessed tokens, main file bytes, compile
+    // command, tool version and rule set. Empty if preprocessing failed.
+    // Non-system files read while preprocessing go to `dependencies` if set.
+    // 翻译单元的缓存键：预处理记号、主文件内容、编译命令、工具版本和规则集。
+    // 预处理失败时返回空串。若提供 `dependencies`，预处理读取的非系统文件写入其中。
+    static std::string computeKey(const clang::tooling::CompilationDatabase& compilations,
+                                  const std::string& file,
+                                  const std::string& ruleSet,
+                                  std::vector<std::string>* dependencies = nullptr);
+    
+    // Replay stored diagnostics on hit / 命中时回放存储的诊断
+    bool lookup(const std::string& key, DiagnosticEngine& diagnostics) const;
+    
+    // Store diagnostics of a successfully analyzed TU / 存储成功分析的翻译单元的诊断
+    void store(const std::string& key, const DiagnosticEngine& diagnostics) const;
+    
+    // Remove least recently used entries until under the size cap
+    // 删除最近最少使用的条目，直到低于大小上限
+    void evict() const;
+
+private:
+    std::string entryPath(const std::string& key) const;
+    
+    std::string directory_;
+    uint64_t maxBytes_;
+};
+
+} // namespace tcc
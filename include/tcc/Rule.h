@@ -8,21 +8,228 @@
 
 #include "tcc/Core.h"
 #include "tcc/Diagnostic.h"
+#include "tcc/TypeClassifier.h"
 #include <clang/AST/ASTContext.h>
-#include <clang/AST/RecursiveASTVisitor.h>
+#include <clang/AST/Decl.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/Expr.h>
+#include <clang/AST/ExprCXX.h>
+#include <clang/AST/Stmt.h>
+#include <llvm/Support/Compiler.h>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 namespace tcc {
 
+// AST node kinds a rule can subscribe to / 规则可订阅的 AST 节点类型
+// The engine walks the AST once and hands each node only to the rules
+// whose interest mask contains its kind.
+// 引擎只遍历一次 AST，并将每个节点仅分发给兴趣掩码包含该类型的规则。
+enum class NodeKind : unsigned {
+    FunctionDecl,
+    VarDecl,
+    FieldDecl,
+    CXXRecordDecl,
+    CXXNewExpr,
+    CXXDeleteExpr,
+    CallExpr,
+    ReturnStmt,
+    LambdaExpr
+};
+
+constexpr size_t NODE_KIND_COUNT = static_cast<size_t>(NodeKind::LambdaExpr) + 1;
+
+// Bit mask of NodeKind values / NodeKind 位掩码
+using NodeMask = unsigned;
+
+constexpr NodeMask nodeBit(NodeKind kind) {
+    return 1u << static_cast<unsigned>(kind);
+}
+
+class Rule;
+class RuleMatchFinder;
+struct RuleStats;
+
+// Arguments every node handler receives / 每个节点处理函数接收的参数
+struct NodeHookContext {
+    clang::ASTContext& context;
+    DiagnosticEngine& diagnostics;
+    clang::FunctionDecl* function;   // Innermost enclosing function or lambda operator / 最内层外围函数或 lambda 调用运算符
+    TypeClassifier& types;           // Shared by the whole traversal / 整个遍历共享
+};
+
+// Node type and handler member of each kind / 每种节点类型对应的节点类和处理成员
+// A rule handling `Kind` declares the matching check*() member; `call`
+// binds it at compile time.
+// 处理 `Kind` 的规则声明对应的 check*() 成员；`call` 在编译期绑定它。
+template <NodeKind Kind>
+struct NodeTraits;
+
+template <>
+struct NodeTraits<NodeKind::FunctionDecl> {
+    using Node = clang::FunctionDecl;
+    template <typename R>
+    static void call(R& rule, Node* node, const NodeHookContext& hook) {
+        rule.checkFunctionDecl(node, hook.context, hook.diagnostics);
+    }
+};
+
+template <>
+struct NodeTraits<NodeKind::VarDecl> {
+    using Node = clang::VarDecl;
+    template <typename R>
+    static void call(R& rule, Node* node, const NodeHookContext& hook) {
+        rule.checkVarDecl(node, hook.context, hook.diagnostics);
+    }
+};
+
+template <>
+struct NodeTraits<NodeKind::FieldDecl> {
+    using Node = clang::FieldDecl;
+    template <typename R>
+    static void call(R& rule, Node* node, const NodeHookContext& hook) {
+        rule.checkFieldDecl(node, hook.context, hook.diagnostics);
+    }
+};
+
+template <>
+struct NodeTraits<NodeKind::CXXRecordDecl> {
+    using Node = clang::CXXRecordDecl;
+    template <typename R>
+    static void call(R& rule, Node* node, const NodeHookContext& hook) {
+        rule.checkRecordDecl(node, hook.context, hook.diagnostics);
+    }
+};
+
+template <>
+struct NodeTraits<NodeKind::CXXNewExpr> {
+    using Node = clang::CXXNewExpr;
+    template <typename R>
+    static void call(R& rule, Node* node, const NodeHookContext& hook) {
+        rule.checkNewExpr(node, hook.context, hook.diagnostics);
+    }
+};
+
+template <>
+struct NodeTraits<NodeKind::CXXDeleteExpr> {
+    using Node = clang::CXXDeleteExpr;
+    template <typename R>
+    static void call(R& rule, Node* node, const NodeHookContext& hook) {
+        rule.checkDeleteExpr(node, hook.context, hook.diagnostics);
+    }
+};
+
+template <>
+struct NodeTraits<NodeKind::CallExpr> {
+    using Node = clang::CallExpr;
+    template <typename R>
+    static void call(R& rule, Node* node, const NodeHookContext& hook) {
+        rule.checkCallExpr(node, hook.context, hook.diagnostics);
+    }
+};
+
+template <>
+struct NodeTraits<NodeKind::ReturnStmt> {
+    using Node = clang::ReturnStmt;
+    template <typename R>
+    static void call(R& rule, Node* node, const NodeHookContext& hook) {
+        rule.checkReturnStmt(node, hook.function, hook.context, hook.diagnostics);
+    }
+};
+
+template <>
+struct NodeTraits<NodeKind::LambdaExpr> {
+    using Node = clang::LambdaExpr;
+    template <typename R>
+    static void call(R& rule, Node* node, const NodeHookContext& hook) {
+        rule.checkLambdaExpr(node, hook.context, hook.diagnostics);
+    }
+};
+
+// Handler of one rule for one node kind / 某规则对某节点类型的处理函数
+template <NodeKind Kind>
+struct NodeHook {
+    using Node = typename NodeTraits<Kind>::Node;
+    
+    Rule* rule;
+    void (*call)(Rule* rule, Node* node, const NodeHookContext& hook);
+    RuleStats* stats;    // Profiling slot, null when not profiling / 分析槽，不分析时为空
+};
+
+// Per-node-kind handler lists for the fused traversal / 融合遍历的按节点类型处理函数列表
+// Each kind has its own typed list, so a node only reaches the handlers
+// registered for it, whatever the number of rules.
+// 每种类型都有自己的类型化列表，无论规则多少，节点只会到达为其注册的处理函数。
+class RuleDispatchTable {
+public:
+    RuleDispatchTable();
+    ~RuleDispatchTable();
+    
+    // Subscribe rule through Rule::subscribe() / 通过 Rule::subscribe() 订阅规则
+    void addRule(Rule* rule, RuleStats* stats = nullptr);
+    
+    template <NodeKind Kind>
+    void addHook(const NodeHook<Kind>& hook) {
+        std::get<static_cast<size_t>(Kind)>(hooks_).push_back(hook);
+    }
+    
+    template <NodeKind Kind>
+    const std::vector<NodeHook<Kind>>& hooksFor() const {
+        return std::get<static_cast<size_t>(Kind)>(hooks_);
+    }
+    
+    // Matchers of MatcherRule rules, created on first use / MatcherRule 规则的匹配器，首次使用时创建
+    RuleMatchFinder& getOrCreateMatchFinder();
+    
+    // Null when no MatcherRule subscribed / 没有 MatcherRule 订阅时为空
+    RuleMatchFinder* getMatchFinder() const { return matchFinder_.get(); }
+    
+    // Some rule handles nodes of the traversal itself; without one only
+    // the matcher pass has work / 有规则处理遍历本身的节点；没有时只有匹配器扫描有工作
+    bool hasHooks() const {
+        return std::apply([](const auto&... lists) { return (!lists.empty() || ...); }, hooks_);
+    }
+    
+    bool empty() const { return !matchFinder_ && !hasHooks(); }
+
+private:
+    template <size_t... Kinds>
+    static std::tuple<std::vector<NodeHook<static_cast<NodeKind>(Kinds)>>...>
+        makeLists(std::index_sequence<Kinds...>);
+    
+    decltype(makeLists(std::make_index_sequence<NODE_KIND_COUNT>())) hooks_;
+    std::unique_ptr<RuleMatchFinder> matchFinder_;
+};
+
+// Cost tier of a rule; the engine runs cheaper tiers first
+// 规则的开销层级；引擎先运行较廉价的层级
+// All tiers share one traversal and one matcher pass, cheaper rules first
+// at each node. Only in gate mode does the Expensive tier run afterwards,
+// in its own pass, and only if the TU has no error yet.
+// 所有层级共享一次遍历和一次匹配器扫描，在每个节点上较廉价的规则先运行。
+// 只有在门禁模式下 Expensive 层级才在之后单独扫描运行，且仅当翻译单元尚无错误时运行。
+enum class RuleCost : uint8_t {
+    Cheap,       // Looks at the node alone / 只看节点本身
+    Moderate,    // Also inspects types, enclosing functions or captures / 还检查类型、外围函数或捕获
+    Expensive    // Whole-TU analyses such as CFG or call graph / CFG 或调用图等整个翻译单元的分析
+};
+
+constexpr size_t RULE_COST_COUNT = static_cast<size_t>(RuleCost::Expensive) + 1;
+
 // Base class for all TCC rules / 所有 TCC 规则的基类
 class Rule {
 public:
-    explicit Rule(std::string id, std::string description, RuleCategory category)
+    explicit Rule(std::string id, std::string description, RuleCategory category,
+                  RuleCost cost = RuleCost::Cheap)
         : id_(std::move(id))
+        , idHandle_(StringPool::global().intern(id_))
         , description_(std::move(description))
-        , category_(category) {}
+        , category_(category)
+        , cost_(cost) {}
     
     virtual ~Rule() = default;
     
@@ -30,55 +237,169 @@ public:
     const std::string& getId() const { return id_; }
     const std::string& getDescription() const { return description_; }
     RuleCategory getCategory() const { return category_; }
+    RuleCost getCost() const { return cost_; }
+    
+    // Node kinds this rule wants from the fused traversal / 此规则需要融合遍历提供的节点类型
+    // Rules returning 0 are run through check() on their own.
+    // 返回 0 的规则通过 check() 单独运行。
+    virtual NodeMask getNodeInterests() const { return 0; }
     
-    // Check if rule applies to this AST node / 检查规则是否适用于此 AST 节点
+    // Add this rule's node handlers to `table`; see NodeRule
+    // 将此规则的节点处理函数加入 `table`；见 NodeRule
+    virtual void subscribe(RuleDispatchTable& /*table*/, RuleStats* /*stats*/) {}
+    
+    // Copy with the same configuration for one shard of a TU, null if the
+    // rule cannot run sharded / 为翻译单元的一个分片复制配置相同的规则，不能分片运行时为空
+    virtual std::unique_ptr<Rule> clone() const { return nullptr; }
+    
+    // Standalone run over the whole TU, stopping early once `cancel` is set
+    // 在整个翻译单元上单独运行，`cancel` 被设置后尽早停止
+    // The default walks the AST with the shared dispatcher for this rule only.
+    // 默认实现仅为此规则使用共享分发器遍历 AST。
     virtual void check(clang::ASTContext& context, 
-                      DiagnosticEngine& diagnostics) = 0;
+                      DiagnosticEngine& diagnostics,
+                      const CancellationToken& cancel);
 
 protected:
+    // Report this rule's `message` at `loc`, shown at the presumed expansion
+    // location. Repeats at the same expansion and spelling location are dropped.
+    // Only the raw location is stored; RuleEngine::analyze resolves it once
+    // at the end of the TU, so reporting is safe from shard threads.
+    // 在 `loc` 报告此规则的 `message`，显示于推定的展开位置。
+    // 同一展开位置和拼写位置的重复报告会被丢弃。
+    // 只存储原始位置；RuleEngine::analyze 在翻译单元结束时统一解析，因此可在分片线程中报告。
+    void report(DiagnosticEngine& diagnostics, clang::ASTContext& context,
+                clang::SourceLocation loc, Severity severity, MessageId message,
+                const std::vector<std::string_view>& arguments = {}) const;
+    
     std::string id_;
+    StringId idHandle_;   // id_ in the global pool / id_ 在全局池中的句柄
     std::string description_;
     RuleCategory category_;
+    RuleCost cost_;
 };
 
 // Rule for ownership checking / 所有权检查规则
 class OwnershipRule : public Rule {
 public:
-    explicit OwnershipRule(std::string id, std::string description)
-        : Rule(std::move(id), std::move(description), RuleCategory::Ownership) {}
+    explicit OwnershipRule(std::string id, std::string description,
+                           RuleCost cost = RuleCost::Cheap)
+        : Rule(std::move(id), std::move(description), RuleCategory::Ownership, cost) {}
 };
 
 // Rule for lifetime checking / 生命周期检查规则
 class LifetimeRule : public Rule {
 public:
-    explicit LifetimeRule(std::string id, std::string description)
-        : Rule(std::move(id), std::move(description), RuleCategory::Lifetime) {}
+    explicit LifetimeRule(std::string id, std::string description,
+                          RuleCost cost = RuleCost::Cheap)
+        : Rule(std::move(id), std::move(description), RuleCategory::Lifetime, cost) {}
 };
 
 // Rule for concurrency checking / 并发检查规则
 class ConcurrencyRule : public Rule {
 public:
-    explicit ConcurrencyRule(std::string id, std::string description)
-        : Rule(std::move(id), std::move(description), RuleCategory::Concurrency) {}
+    explicit ConcurrencyRule(std::string id, std::string description,
+                             RuleCost cost = RuleCost::Cheap)
+        : Rule(std::move(id), std::move(description), RuleCategory::Concurrency, cost) {}
+};
+
+// Base of rules fed by the fused traversal / 由融合遍历提供节点的规则基类
+// `Kinds` lists the node kinds handled; Derived declares the matching
+// check*() members (see NodeTraits), called directly without RTTI or
+// virtual dispatch. Handlers only see nodes in the main file.
+// `Kinds` 列出处理的节点类型；Derived 声明对应的 check*() 成员（见 NodeTraits），
+// 直接调用，无需 RTTI 或虚分派。处理函数只会收到主文件中的节点。
+template <typename Derived, typename Base, NodeKind... Kinds>
+class NodeRule : public Base {
+    static_assert(sizeof...(Kinds) > 0, "NodeRule needs at least one node kind");
+
+public:
+    using Base::Base;
+    
+    NodeMask getNodeInterests() const final { return (nodeBit(Kinds) | ...); }
+    
+    void subscribe(RuleDispatchTable& table, RuleStats* stats) final {
+        (table.addHook<Kinds>({this, &dispatch<Kinds>, stats}), ...);
+    }
+    
+    std::unique_ptr<Rule> clone() const final {
+        return std::make_unique<Derived>(static_cast<const Derived&>(*this));
+    }
+
+private:
+    template <NodeKind Kind>
+    static void dispatch(Rule* rule, typename NodeTraits<Kind>::Node* node,
+                         const NodeHookContext& hook) {
+        NodeTraits<Kind>::call(*static_cast<Derived*>(rule), node, hook);
+    }
+};
+
+// Rule plugin interface / 规则插件接口
+// A plugin is a shared library built against these headers that is not
+// linked with tcc-core. It contains TCC_RULE_PLUGIN() once and one
+// RuleRegistry::Add<MyRule> per rule. Plugin rules must derive from
+// NodeRule or MatcherRule so they join the engine's single traversal,
+// and report with MessageId::PluginRule and their English and Chinese text.
+// 插件是基于这些头文件构建、且不链接 tcc-core 的共享库。它包含一次 TCC_RULE_PLUGIN()，
+// 每条规则一个 RuleRegistry::Add<MyRule>。插件规则必须派生自 NodeRule 或 MatcherRule，
+// 以加入引擎的单次遍历，并以 MessageId::PluginRule 及其中英文文本报告。
+constexpr unsigned RULE_PLUGIN_API_VERSION = 3;
+
+#define TCC_RULE_PLUGIN()                                                   \
+    extern "C" LLVM_ATTRIBUTE_VISIBILITY_DEFAULT unsigned                   \
+    tccRulePluginApiVersion() { return ::tcc::RULE_PLUGIN_API_VERSION; }
+
+// Creates one instance of a rule; every engine gets its own
+// 创建规则的一个实例；每个引擎各有自己的实例
+using RuleFactory = std::unique_ptr<Rule> (*)();
+
+// Rules of one shared library loaded with --load / 一个通过 --load 加载的共享库中的规则
+struct RulePlugin {
+    std::string path;                   // Real path / 真实路径
+    std::string identity;               // Real path, size and mtime when loaded / 加载时的真实路径、大小和修改时间
+    std::vector<RuleFactory> factories;
 };
 
 // Rule registry / 规则注册表
+// Holds factories rather than rules: rules keep per-TU state, and each
+// worker's engine needs its own instances. Filled at startup only.
+// 保存工厂而不是规则：规则持有每个翻译单元的状态，每个工作线程的引擎需要自己的实例。
+// 仅在启动时填充。
 class RuleRegistry {
 public:
     static RuleRegistry& instance();
     
-    // Register a rule / 注册规则
-    void registerRule(std::unique_ptr<Rule> rule);
+    // Registers `RuleType` from a static initializer / 在静态初始化器中注册 `RuleType`
+    template <typename RuleType>
+    class Add {
+    public:
+        Add() { instance().registerFactory(&create); }
+    
+    private:
+        static std::unique_ptr<Rule> create() { return std::make_unique<RuleType>(); }
+    };
     
-    // Get all rules / 获取所有规则
-    const std::vector<std::unique_ptr<Rule>>& getRules() const { return rules_; }
+    // Factories go to the plugin being loaded, else to the linked-in set
+    // 工厂归入正在加载的插件，否则归入静态链接的集合
+    void registerFactory(RuleFactory factory);
     
-    // Get rules by category / 按类别获取规则
-    std::vector<Rule*> getRulesByCategory(RuleCategory category) const;
+    // Rules linked into the executable itself / 直接链接进可执行文件的规则
+    const std::vector<RuleFactory>& getLinkedFactories() const { return linked_; }
+    
+    // Load a plugin once; a path loaded before returns the same plugin.
+    // Null with `error` set if it cannot be opened, was built for another
+    // plugin API version, registers no rule, has a rule without node
+    // interests, or changed on disk since it was loaded.
+    // 加载插件一次；再次加载同一路径返回同一插件。无法打开、API 版本不符、未注册规则、
+    // 有规则没有节点兴趣或自加载以来在磁盘上已改变时返回空并设置 `error`。
+    const RulePlugin* loadPlugin(const std::string& path, std::string& error);
 
 private:
     RuleRegistry() = default;
-    std::vector<std::unique_ptr<Rule>> rules_;
+    
+    std::vector<RuleFactory> linked_;
+    std::vector<std::unique_ptr<RulePlugin>> plugins_;
+    RulePlugin* loading_ = nullptr;   // Set while a library's initializers run / 库的初始化器运行期间设置
 };
 
 } // namespace tcc
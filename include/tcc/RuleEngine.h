@@ -6,39 +6,125 @@
 
 #pragma once
 
+#include "tcc/ApiCatalog.h"
 #include "tcc/Core.h"
 #include "tcc/Diagnostic.h"
+#include "tcc/FileDetector.h"
 #include "tcc/Rule.h"
+#include "tcc/TimeReport.h"
 #include <clang/AST/ASTContext.h>
 #include <string>
 #include <vector>
 
 namespace tcc {
 
+// Set of rule categories, one bit per RuleCategory / 规则类别集合，每个 RuleCategory 一位
+using CategoryMask = unsigned;
+
+constexpr CategoryMask categoryBit(RuleCategory category) {
+    return 1u << static_cast<unsigned>(category);
+}
+
 // Main rule engine / 主规则引擎
 class RuleEngine {
 public:
     RuleEngine();
     
-    // Initialize with default rules / 使用默认规则初始化
+    // Allocation API catalog for the default rules, null = built-in; must
+    // be set before initializeDefaultRules and outlive the engine
+    // 默认规则使用的分配 API 目录，空 = 内置；须在 initializeDefaultRules 之前设置且生命期长于引擎
+    void setApiCatalog(const ApiCatalog* catalog) { apiCatalog_ = catalog; }
+    
+    // Initialize with default rules and those registered through
+    // RuleRegistry::Add in the executable / 使用默认规则及可执行文件中经 RuleRegistry::Add 注册的规则初始化
     void initializeDefaultRules();
     
+    // Add a fresh instance of every rule of `plugin` / 添加 `plugin` 中每条规则的新实例
+    void addPluginRules(const RulePlugin& plugin);
+    
     // Add custom rule / 添加自定义规则
     void addRule(std::unique_ptr<Rule> rule);
     
-    // Run all rules on AST / 在 AST 上运行所有规则
+    // Run all rules on AST, cheapest cost tier first, in one fused traversal
+    // 对 AST 运行所有规则，最廉价的开销层级优先，共用一次融合遍历
     void analyze(clang::ASTContext& context, DiagnosticEngine& diagnostics);
     
+    // Run only rules whose category is in the mask; traversals and the
+    // remaining standalone rules stop once `cancel` is set
+    // 只运行类别在掩码中的规则；`cancel` 被设置后遍历和剩余的独立规则停止
+    void analyze(clang::ASTContext& context, DiagnosticEngine& diagnostics,
+                 CategoryMask categories, const CancellationToken& cancel);
+    
     // Enable/disable rule categories / 启用/禁用规则类别
     void enableCategory(RuleCategory category, bool enabled = true);
     bool isCategoryEnabled(RuleCategory category) const;
     
+    // Globally enabled categories narrowed by a file's @tcc-no-* options
+    // 全局启用的类别再按文件的 @tcc-no-* 选项收窄
+    CategoryMask getCategoryMask(const TCCConfig& config) const;
+    
     // Get statistics / 获取统计信息
     size_t getRuleCount() const;
     size_t getActiveRuleCount() const;
+    
+    // Split the traversal of each TU across up to `threads` threads once it
+    // is parsed; 0 or 1 = one thread. TUs with a PCH or with few top-level
+    // declarations are checked on one thread.
+    // 在每个翻译单元解析完成后，将其遍历拆分到最多 `threads` 个线程；0 或 1 = 单线程。
+    // 使用 PCH 或顶层声明较少的翻译单元在单线程上检查。
+    void setTraversalThreads(unsigned threads) { traversalThreads_ = threads; }
+    
+    // Skip Expensive rules in TUs that cheaper rules already rejected; errors
+    // later accepted by a baseline still count
+    // 对已被较廉价规则拒绝的翻译单元跳过 Expensive 规则；之后被基线接受的错误仍计入
+    void setGateMode(bool enabled = true) { gate_ = enabled; }
+    
+    // Time every rule hook and standalone check / 为每个规则钩子和独立检查计时
+    void enableProfiling(bool enabled = true);
+    
+    // Add accumulated per-rule costs to the report / 将累计的每规则开销加入报告
+    void reportProfile(TimeReport& report) const;
+    
+    // IDs of active rules plus the API catalog and the identity of every
+    // plugin, identifies the rule set in cache keys
+    // 活动规则的 ID 加上 API 目录和每个插件的标识，用于在缓存键中标识规则集
+    std::string getRuleSetSignature() const;
 
 private:
+    // Declarations below this per shard are not worth a thread / 每个分片低于此数量的声明不值得一个线程
+    static constexpr size_t MIN_UNITS_PER_SHARD = 64;
+    
+    // Top-level declarations located in the main file / 位于主文件中的顶层声明
+    static std::vector<clang::Decl*> collectMainFileDecls(clang::ASTContext& context);
+    
+    // Units a sharded traversal splits `decls` into / 分片遍历将 `decls` 拆分成的单元
+    static std::vector<clang::Decl*> collectShardUnits(const std::vector<clang::Decl*>& decls);
+    
+    // Run `rules`: one traversal for node rules, one pass for matcher rules,
+    // then the standalone ones in order
+    // 运行 `rules`：节点规则共用一次遍历，匹配器规则共用一次扫描，其余独立规则依次运行
+    void runRules(clang::ASTContext& context, DiagnosticEngine& diagnostics,
+                  const std::vector<size_t>& rules, const CancellationToken& cancel);
+    
+    // Measured wall seconds per hook call, match or standalone run, 0 until
+    // measured. Hooks and matches are only measured while profiling.
+    // 每次钩子调用、匹配或独立运行的实测墙钟秒数，未测量时为 0。钩子和匹配仅在分析时测量。
+    double getCostPerCall(size_t index) const;
+    
+    // Run the traversal rules on shard threads, merging their diagnostics
+    // in shard order; false if the TU must be traversed on one thread
+    // 在分片线程上运行遍历规则，并按分片顺序合并诊断；翻译单元须单线程遍历时返回 false
+    bool traverseSharded(clang::ASTContext& context, DiagnosticEngine& diagnostics,
+                         const std::vector<size_t>& traversalRules,
+                         const CancellationToken& cancel);
+    
     std::vector<std::unique_ptr<Rule>> rules_;
+    std::vector<RuleStats> ruleStats_;   // Parallel to rules_ / 与 rules_ 平行
+    const ApiCatalog* apiCatalog_ = nullptr;
+    std::string pluginIdentities_;   // Of addPluginRules() calls / 来自 addPluginRules() 调用
+    bool profiling_ = false;
+    unsigned traversalThreads_ = 1;
+    bool gate_ = false;
     bool ownershipEnabled_ = true;
     bool lifetimeEnabled_ = true;
     bool concurrencyEnabled_ = true;
@@ -0,0 +1,117 @@
+﻿// Tough C Profiler - Binary Shard Results
+// Tough C 分析器 - 二进制分片结果
+//
+// Compact result files written per CI shard and merged by tcc-merge
+// 每个 CI 分片写出的紧凑结果文件，由 tcc-merge 合并
+
+#pragma once
+
+#include "tcc/Diagnostic.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace llvm {
+class MemoryBuffer;
+}
+
+namespace tcc {
+
+// File layout, little-endian / 文件布局（小端）:
+//   ShardHeader
+//   ShardString[stringCount]     offsets into the string bytes / 字符串字节中的偏移
+//   string bytes, padded to 8    / 字符串字节，补齐到 8
+//   ShardRecord[recordCount]     sorted by compareShardRecords / 按 compareShardRecords 排序
+struct ShardHeader {
+    char magic[4];              // "TCCS"
+    uint32_t version;
+    uint32_t stringCount;
+    uint32_t recordCount;
+    uint64_t stringBytes;       // Size before padding / 补齐前的大小
+};
+
+struct ShardString {
+    uint32_t offset;
+    uint32_t length;
+};
+
+// One diagnostic; strings are indices into the shard's table
+// 一条诊断；字符串为分片字符串表中的索引
+struct ShardRecord {
+    uint32_t file;
+    uint32_t line;
+    uint32_t column;
+    uint32_t ruleId;
+    uint32_t arguments[Diagnostic::MAX_ARGUMENTS];
+    uint16_t message;
+    uint8_t severity;
+    uint8_t category;
+    uint8_t argumentCount;
+    uint8_t reserved[3];
+};
+
+static_assert(sizeof(ShardHeader) == 24, "shard header layout / 分片头布局");
+static_assert(sizeof(ShardRecord) == 32, "shard record layout / 分片记录布局");
+
+// Collects diagnostics and writes them as one sorted shard on finish()
+// 收集诊断，并在 finish() 时写出为一个有序分片
+class ShardWriter : public DiagnosticSink {
+public:
+    explicit ShardWriter(std::string path);
+    
+    void handle(const Diagnostic& diag) override;
+    void finish() override;
+    
+    // Empty unless finish() failed / finish() 失败时非空
+    const std::string& getError() const { return error_; }
+
+private:
+    std::string path_;
+    std::string error_;
+    std::vector<Diagnostic> diagnostics_;   // 32-byte records / 32 字节记录
+};
+
+// Read-only view of a memory-mapped shard / 内存映射分片的只读视图
+class ShardReader {
+public:
+    ShardReader();
+    ~ShardReader();
+    ShardReader(ShardReader&&) noexcept;
+    ShardReader& operator=(ShardReader&&) noexcept;
+    
+    // Map and validate `path`; false with `error` set if it is not a shard
+    // 映射并校验 `path`；若不是分片则返回 false 并设置 `error`
+    bool open(const std::string& path, std::string& error);
+    
+    size_t size() const { return recordCount_; }
+    ShardRecord getRecord(size_t index) const;
+    std::string_view getString(uint32_t index) const;
+    
+    // Decode a record, interning its strings once per shard
+    // 解码记录，每个分片的字符串只驻留一次
+    Diagnostic toDiagnostic(const ShardRecord& record) const;
+
+private:
+    std::unique_ptr<llvm::MemoryBuffer> buffer_;
+    const char* stringIndex_ = nullptr;   // ShardString[], read via memcpy / 通过 memcpy 读取
+    const char* stringBytes_ = nullptr;
+    const char* records_ = nullptr;
+    uint32_t stringCount_ = 0;
+    uint32_t recordCount_ = 0;
+    mutable std::vector<StringId> interned_;   // Shard index -> pool ID / 分片索引 -> 池 ID
+};
+
+// Shard order: file, line, column, rule ID, message, arguments; 0 if equal
+// 分片顺序：文件、行、列、规则 ID、消息、参数；相等时为 0
+int compareShardRecords(const ShardReader& a, const ShardRecord& left,
+                        const ShardReader& b, const ShardRecord& right);
+
+// K-way merge of sorted shards into `sink`, dropping duplicates; returns
+// the number of diagnostics written
+// 将有序分片 k 路归并到 `sink` 并去重；返回写出的诊断数
+size_t mergeShards(const std::vector<ShardReader>& shards, DiagnosticSink& sink);
+
+} // namespace tcc
@@ -0,0 +1,60 @@
+﻿// Tough C Profiler - Shared Precompiled Headers
+// Tough C 分析器 - 共享预编译头
+//
+// Precompiles the include prefix shared by a batch, once per flag set
+// 为一批文件共享的包含前缀预编译，每组编译标志一次
+
+#pragma once
+
+#include "tcc/Core.h"
+
+#include <clang/Tooling/CompilationDatabase.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace tcc {
+
+// Shared PCH builder / 共享 PCH 构建器
+// Files compiled with the same flags are grouped; the longest common run of
+// leading `#include <...>` lines in a group becomes a PCH under
+// <directory>/pch, reused across runs while flags and prefix stay the same.
+// A stamp file beside it records the size and modification time of every
+// header the PCH read; a changed header rebuilds it.
+// 使用相同标志编译的文件被分为一组；组内开头 `#include <...>` 行的最长公共
+// 序列被预编译到 <directory>/pch 下，只要标志和前缀不变即可跨运行复用。
+// 旁边的戳文件记录 PCH 读取的每个头文件的大小和修改时间；头文件改变时重新构建。
+class SharedPCH {
+public:
+    SharedPCH(const clang::tooling::CompilationDatabase& compilations,
+              std::string directory);
+    
+    // Find or build PCHs for the batch; call before checking starts
+    // 为该批文件查找或构建 PCH；在检查开始前调用
+    void prepare(const std::vector<std::string>& files, bool verbose,
+                 llvm::raw_ostream& log);
+    
+    // PCH to pass with -include-pch, empty if none / 通过 -include-pch 传入的 PCH，无则为空
+    std::string getPCHFor(const std::string& file) const;
+    
+    // Leading system includes of a file / 文件开头的系统头包含
+    static std::vector<std::string> scanIncludePrefix(const std::string& file);
+
+private:
+    // Flags that must match for a PCH to be reusable / PCH 可复用时必须一致的标志
+    std::string getFlagSetKey(const std::string& file) const;
+    
+    // Compile one prefix header and stamp its inputs; false on failure
+    // 编译一个前缀头并记录其输入的戳；失败时返回 false
+    bool build(const std::string& sampleFile, const std::vector<std::string>& prefix,
+               const std::string& headerPath, const std::string& pchPath,
+               const std::string& stampPath);
+    
+    const clang::tooling::CompilationDatabase& compilations_;
+    std::string directory_;
+    std::map<std::string, std::string> pchByFile_;
+};
+
+} // namespace tcc
@@ -0,0 +1,65 @@
+﻿// Tough C Profiler - Source Location Resolution
+// Tough C 分析器 - 源码位置解析
+//
+// Resolves raw Clang locations of one TU, caching per FileID
+// 解析单个翻译单元的原始 Clang 位置，按 FileID 缓存
+
+#pragma once
+
+#include "tcc/Diagnostic.h"
+
+#include <clang/Basic/SourceLocation.h>
+#include <clang/Basic/SourceManager.h>
+#include <llvm/ADT/DenseMap.h>
+
+#include <mutex>
+
+namespace tcc {
+
+// Presumed locations from a SourceManager / 来自 SourceManager 的推定位置
+// The file name is looked up and interned once per FileID; lines and
+// columns come from the file's line table. Files with #line directives
+// fall back to getPresumedLoc.
+// 每个 FileID 只查找并驻留一次文件名；行和列来自该文件的行表。含 #line 指令的文件回退到 getPresumedLoc。
+class SourceManagerResolver : public LocationResolver {
+public:
+    explicit SourceManagerResolver(const clang::SourceManager& sm) : sm_(sm) {}
+    
+    SourceLocation resolve(uint32_t rawLocation) override;
+    uint32_t getSpelling(uint32_t rawLocation) override;
+
+private:
+    struct FileInfo {
+        StringId name;          // Presumed file name / 推定文件名
+        bool lineDirectives;    // Names and lines may be remapped / 名称和行可能被重映射
+    };
+    
+    const clang::SourceManager& sm_;
+    llvm::DenseMap<clang::FileID, FileInfo> files_;
+};
+
+// Another resolver shared between threads / 在线程间共享的另一个解析器
+// `mutex` must also guard every other use of the same SourceManager,
+// whose lookup caches are not thread-safe.
+// `mutex` 也须保护对同一 SourceManager 的所有其他使用，因为其查找缓存不是线程安全的。
+class LockedResolver : public LocationResolver {
+public:
+    LockedResolver(LocationResolver& resolver, std::mutex& mutex)
+        : resolver_(resolver), mutex_(mutex) {}
+    
+    SourceLocation resolve(uint32_t rawLocation) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return resolver_.resolve(rawLocation);
+    }
+    
+    uint32_t getSpelling(uint32_t rawLocation) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return resolver_.getSpelling(rawLocation);
+    }
+
+private:
+    LocationResolver& resolver_;
+    std::mutex& mutex_;
+};
+
+} // namespace tcc
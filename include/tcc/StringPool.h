@@ -0,0 +1,51 @@
+﻿// Tough C Profiler - String Pool
+// Tough C 分析器 - 字符串池
+//
+// Process-wide interning of file names and rule IDs
+// 进程范围内对文件名和规则 ID 的驻留
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace tcc {
+
+// Handle of an interned string / 驻留字符串的句柄
+using StringId = uint32_t;
+
+// Append-only string table; handles stay valid until truncate() drops them.
+// Safe to use from concurrent workers.
+// 只追加的字符串表；句柄在被 truncate() 丢弃之前有效。可供并发工作线程使用。
+class StringPool {
+public:
+    // Pool shared by all diagnostics / 所有诊断共享的字符串池
+    static StringPool& global();
+    
+    // Handle of `value`, adding it on first use / `value` 的句柄，首次使用时加入
+    StringId intern(std::string_view value);
+    
+    // String of a handle returned by intern() / intern() 返回的句柄对应的字符串
+    const std::string& get(StringId id) const;
+    
+    // Number of interned strings, usable as a mark for truncate()
+    // 已驻留字符串的数量，可作为 truncate() 的标记
+    size_t size() const;
+    
+    // Drop every string interned after `mark` was taken. The caller must hold
+    // no handle past the mark, as between two requests of the daemon.
+    // 丢弃在取得 `mark` 之后驻留的所有字符串。调用者不得持有标记之后的句柄，
+    // 例如守护进程的两次请求之间。
+    void truncate(size_t mark);
+
+private:
+    mutable std::mutex mutex_;
+    std::deque<std::string> strings_;   // Stable addresses / 地址稳定
+    std::unordered_map<std::string_view, StringId> ids_;
+};
+
+} // namespace tcc
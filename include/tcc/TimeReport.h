@@ -0,0 +1,80 @@
+﻿// Tough C Profiler - Time Report
+// Tough C 分析器 - 时间报告
+//
+// Self-profiling of phases and rules for --time-report
+// 用于 --time-report 的阶段和规则自我分析
+
+#pragma once
+
+#include "tcc/Core.h"
+
+#include <llvm/Support/raw_ostream.h>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tcc {
+
+// Wall and CPU time since construction; CPU time is per thread
+// 自构造以来的墙钟时间和 CPU 时间；CPU 时间按线程计
+class Stopwatch {
+public:
+    Stopwatch();
+    
+    double wallSeconds() const;
+    double cpuSeconds() const;
+    
+    // CPU time of the calling thread / 调用线程的 CPU 时间
+    static double threadCpuSeconds();
+
+private:
+    std::chrono::steady_clock::time_point wallStart_;
+    double cpuStart_;
+};
+
+// Accumulated time of a phase / 阶段的累计时间
+struct PhaseStats {
+    double wallSeconds = 0;
+    double cpuSeconds = 0;
+    uint64_t count = 0;      // Times entered / 进入次数
+};
+
+// Accumulated cost of a rule / 规则的累计开销
+struct RuleStats {
+    double wallSeconds = 0;
+    double cpuSeconds = 0;
+    uint64_t nodes = 0;          // Hook invocations and matches / 钩子调用和匹配次数
+    uint64_t runs = 0;           // Standalone check() runs / 独立 check() 运行次数
+    uint64_t diagnostics = 0;    // Diagnostics emitted / 发出的诊断数
+    
+    void add(const RuleStats& other);
+};
+
+// Thread-safe collector / 线程安全的收集器
+// Phase times are summed over TUs, so under -j they can exceed the elapsed time.
+// 阶段时间按翻译单元累加，因此在 -j 下可能超过实际耗时。
+class TimeReport {
+public:
+    void addPhase(const std::string& phase, double wallSeconds, double cpuSeconds);
+    void addPhase(const std::string& phase, const Stopwatch& stopwatch);
+    void addRule(const std::string& ruleId, const RuleStats& stats);
+    
+    // End-to-end wall time / 端到端墙钟时间
+    void setElapsed(double wallSeconds);
+    
+    void printTable(llvm::raw_ostream& os) const;
+    void printJSON(llvm::raw_ostream& os) const;
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<std::pair<std::string, PhaseStats>> phases_;   // First-seen order / 首次出现顺序
+    std::map<std::string, RuleStats> rules_;
+    double elapsedSeconds_ = 0;
+};
+
+} // namespace tcc
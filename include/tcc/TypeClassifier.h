@@ -0,0 +1,55 @@
+﻿// Tough C Profiler - Type Classifier
+// Tough C 分析器 - 类型分类器
+//
+// Classifies standard library types for rules, once per declaration
+// 为规则分类标准库类型，每个声明只分类一次
+
+#pragma once
+
+#include <clang/AST/Type.h>
+#include <llvm/ADT/DenseMap.h>
+
+#include <cstdint>
+
+namespace clang {
+class CXXRecordDecl;
+class Decl;
+}
+
+namespace tcc {
+
+// Standard library type families rules care about / 规则关心的标准库类型族
+enum class TypeClass : uint8_t {
+    Other,           // Anything else, including user types / 其他，包括用户类型
+    SmartPointer,    // unique_ptr, shared_ptr, weak_ptr, auto_ptr
+    Container,       // Element containers: vector, list, set, ... / 元素容器
+    Map,             // Key/value containers: map, unordered_map, ... / 键值容器
+    String,          // basic_string
+    View,            // basic_string_view, span
+    Atomic,          // atomic, atomic_ref, atomic_flag
+    Mutex,           // mutex and its recursive, timed and shared variants / mutex 及其变体
+    Lock,            // lock_guard, unique_lock, scoped_lock, shared_lock
+    SyncPrimitive    // condition_variable, once_flag, semaphores, latch, barrier / 其他同步原语
+};
+
+// Per-TU classification cache / 每个翻译单元的分类缓存
+// Only records declared in namespace std (or an inline namespace in it)
+// are classified, so a user type named `my_atomic_log` stays Other. All
+// specializations of a template share one entry, keyed on the canonical
+// template declaration; no type strings are built.
+// 只对声明在 std 命名空间（或其中的内联命名空间）中的类分类，因此名为 `my_atomic_log`
+// 的用户类型仍为 Other。模板的所有特化共享一个以规范模板声明为键的条目；不构建类型字符串。
+class TypeClassifier {
+public:
+    // Class of `type`, looking through sugar and cv-qualifiers but not
+    // pointers, references or arrays
+    // `type` 的类别，穿透类型糖和 cv 限定符，但不穿透指针、引用或数组
+    TypeClass classify(clang::QualType type);
+
+private:
+    static TypeClass classifyRecord(const clang::CXXRecordDecl& record);
+    
+    llvm::DenseMap<const clang::Decl*, TypeClass> cache_;
+};
+
+} // namespace tcc
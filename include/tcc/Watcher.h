@@ -0,0 +1,54 @@
+﻿// Tough C Profiler - Watch Mode
+// Tough C 分析器 - 监视模式
+//
+// Keeps results in memory and re-checks only TUs affected by file changes
+// 将结果保存在内存中，仅重新检查受文件变更影响的翻译单元
+
+#pragma once
+
+#include "tcc/Core.h"
+#include "tcc/Driver.h"
+
+#include <llvm/Support/raw_ostream.h>
+
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace tcc {
+
+// Include-graph driven watcher (inotify, Linux only) / 基于包含图的监视器（inotify，仅 Linux）
+class Watcher {
+public:
+    using ReportFn = std::function<void(const std::vector<TUResult>&)>;
+    
+    // The driver must record dependencies / 驱动必须记录依赖
+    Watcher(Driver& driver, const clang::tooling::CompilationDatabase& compilations,
+            llvm::raw_ostream& log);
+    
+    // Check all files, then re-check affected TUs after every change until
+    // interrupted; `report` sees the full result set after each pass.
+    // Returns an ExitCode only on failure.
+    // 检查所有文件，之后每次变更时重新检查受影响的翻译单元，直到被中断；
+    // 每轮结束后 `report` 获得完整结果集。仅在失败时返回 ExitCode。
+    int run(const std::vector<std::string>& files, const ReportFn& report);
+
+private:
+    // Record the TU's files in the reverse include graph / 在反向包含图中记录翻译单元的文件
+    void index(size_t tu);
+    
+    // Absolute, symlink-free path / 绝对且无符号链接的路径
+    static std::string canonicalize(const std::string& path, const std::string& directory);
+    
+    Driver& driver_;
+    const clang::tooling::CompilationDatabase& compilations_;
+    llvm::raw_ostream& log_;
+    std::vector<TUResult> results_;
+    std::map<std::string, std::set<size_t>> dependents_;   // File -> TUs / 文件 -> 翻译单元
+    std::vector<std::set<std::string>> filesOf_;           // TU -> files / 翻译单元 -> 文件
+    std::set<std::string> directories_;                     // Directories to watch / 要监视的目录
+};
+
+} // namespace tcc
@@ -2,105 +2,117 @@
 // Tough C 分析器 - AST 访问者实现
 
 #include "tcc/ASTVisitor.h"
-#include "tcc/OwnershipRules.h"
 
 #include <clang/AST/ASTContext.h>
+#include <clang/AST/ExprCXX.h>
 #include <clang/Basic/SourceManager.h>
 
 namespace tcc {
 
-bool TCCASTVisitor::VisitFunctionDecl(clang::FunctionDecl* decl) {
-    if (!decl || !isInMainFile(decl->getLocation())) {
-        return true;
-    }
+// MainFileFilter Implementation / MainFileFilter 实现
+
+MainFileFilter::MainFileFilter(const clang::SourceManager& sm, std::mutex& mutex)
+    : sm_(sm), mutex_(mutex) {
+    clang::FileID mainFile = sm.getMainFileID();
+    begin_ = sm.getLocForStartOfFile(mainFile);
+    end_ = sm.getLocForEndOfFile(mainFile);
     
-    // Function declarations are checked by specific rules
-    // 函数声明由特定规则检查
-    return true;
+    // #line can move main-file text into another presumed file
+    // #line 可将主文件文本移到另一个推定文件中
+    bool invalid = false;
+    const auto& entry = sm.getSLocEntry(mainFile, &invalid);
+    offsetsExact_ = !invalid && entry.isFile() && !entry.getFile().hasLineDirectives();
 }
 
-bool TCCASTVisitor::VisitVarDecl(clang::VarDecl* decl) {
-    if (!decl || !isInMainFile(decl->getLocation())) {
+bool MainFileFilter::contains(clang::SourceLocation loc) const {
+    if (loc.isInvalid()) {
+        return false;
+    }
+    if (offsetsExact_ && loc.isFileID() && !(loc < begin_) && !(end_ < loc)) {
         return true;
     }
     
-    // Variable declarations are checked by specific rules
-    // 变量声明由特定规则检查
-    return true;
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sm_.isInMainFile(loc);
 }
 
-bool TCCASTVisitor::VisitCXXNewExpr(clang::CXXNewExpr* expr) {
-    if (!expr || !isInMainFile(expr->getLocation())) {
-        return true;
+// TCCASTVisitor Implementation / TCCASTVisitor 实现
+
+bool TCCASTVisitor::TraverseDecl(clang::Decl* decl) {
+    // Returning false unwinds the whole traversal / 返回 false 会结束整个遍历
+    if (cancel_.isCancelled()) {
+        return false;
     }
     
-    // Found a 'new' expression - let rules handle it
-    // 发现 'new' 表达式 - 让规则处理
-    for (const auto& rule : rules_) {
-        if (auto* ownershipRule = dynamic_cast<ForbidNewRule*>(rule.get())) {
-            ownershipRule->checkNewExpr(expr, context_, diagnostics_);
-        }
+    auto* func = llvm::dyn_cast_or_null<clang::FunctionDecl>(decl);
+    if (!func || !func->doesThisDeclarationHaveABody()) {
+        return Base::TraverseDecl(decl);
     }
     
-    return true;
+    functionStack_.push_back(func);
+    bool result = Base::TraverseDecl(decl);
+    functionStack_.pop_back();
+    return result;
+}
+
+bool TCCASTVisitor::TraverseLambdaExpr(clang::LambdaExpr* expr,
+                                       DataRecursionQueue* queue) {
+    // Lambda bodies are traversed as statements, not through their
+    // call operator, so push it here / lambda 体作为语句遍历，需在此压入调用运算符
+    functionStack_.push_back(expr->getCallOperator());
+    bool result = Base::TraverseLambdaExpr(expr, queue);
+    functionStack_.pop_back();
+    return result;
+}
+
+bool TCCASTVisitor::VisitFunctionDecl(clang::FunctionDecl* decl) {
+    return notify<NodeKind::FunctionDecl>(decl, decl->getLocation());
+}
+
+bool TCCASTVisitor::VisitVarDecl(clang::VarDecl* decl) {
+    return notify<NodeKind::VarDecl>(decl, decl->getLocation());
+}
+
+bool TCCASTVisitor::VisitFieldDecl(clang::FieldDecl* decl) {
+    return notify<NodeKind::FieldDecl>(decl, decl->getLocation());
+}
+
+bool TCCASTVisitor::VisitCXXRecordDecl(clang::CXXRecordDecl* decl) {
+    return notify<NodeKind::CXXRecordDecl>(decl, decl->getLocation());
+}
+
+bool TCCASTVisitor::VisitCXXNewExpr(clang::CXXNewExpr* expr) {
+    return notify<NodeKind::CXXNewExpr>(expr, expr->getBeginLoc());
 }
 
 bool TCCASTVisitor::VisitCXXDeleteExpr(clang::CXXDeleteExpr* expr) {
-    if (!expr || !isInMainFile(expr->getLocation())) {
-        return true;
-    }
-    
-    // Found a 'delete' expression - let rules handle it
-    // 发现 'delete' 表达式 - 让规则处理
-    for (const auto& rule : rules_) {
-        if (auto* ownershipRule = dynamic_cast<ForbidDeleteRule*>(rule.get())) {
-            ownershipRule->checkDeleteExpr(expr, context_, diagnostics_);
-        }
-    }
-    
-    return true;
+    return notify<NodeKind::CXXDeleteExpr>(expr, expr->getBeginLoc());
+}
+
+bool TCCASTVisitor::VisitCallExpr(clang::CallExpr* expr) {
+    return notify<NodeKind::CallExpr>(expr, expr->getBeginLoc());
 }
 
 bool TCCASTVisitor::VisitReturnStmt(clang::ReturnStmt* stmt) {
-    if (!stmt || !isInMainFile(stmt->getReturnLoc())) {
+    // Return rules need the enclosing function / return 规则需要外围函数
+    if (functionStack_.empty()) {
         return true;
     }
-    
-    // Return statements are checked by lifetime rules
-    // return 语句由生命周期规则检查
-    return true;
+    return notify<NodeKind::ReturnStmt>(stmt, stmt->getReturnLoc());
 }
 
 bool TCCASTVisitor::VisitLambdaExpr(clang::LambdaExpr* expr) {
-    if (!expr || !isInMainFile(expr->getLocation())) {
-        return true;
-    }
-    
-    // Lambda expressions are checked by concurrency rules
-    // Lambda 表达式由并发规则检查
-    return true;
+    return notify<NodeKind::LambdaExpr>(expr, expr->getBeginLoc());
 }
 
-bool TCCASTVisitor::VisitCXXConstructExpr(clang::CXXConstructExpr* expr) {
-    if (!expr || !isInMainFile(expr->getLocation())) {
-        return true;
+void TCCASTVisitor::runMatchers() {
+    RuleMatchFinder* matchers = dispatch_.getMatchFinder();
+    if (!matchers || cancel_.isCancelled()) {
+        return;
     }
     
-    // Check for std::thread construction
-    // 检查 std::thread 构造
-    const auto* ctorDecl = expr->getConstructor();
-    if (!ctorDecl) {
-        return true;
-    }
-    
-    const auto* recordDecl = ctorDecl->getParent();
-    if (!recordDecl) {
-        return true;
-    }
-    
-    // Thread construction is checked by concurrency rules
-    // 线程构造由并发规则检查
-    return true;
+    NodeHookContext hook{context_, diagnostics_, nullptr, types_};
+    matchers->matchAST(hook, cancel_);
 }
 
 SourceLocation TCCASTVisitor::getSourceLocation(clang::SourceLocation loc) const {
@@ -119,6 +131,9 @@ SourceLocation TCCASTVisitor::getSourceLocation(clang::SourceLocation loc) const
 }
 
 bool TCCASTVisitor::isInMainFile(clang::SourceLocation loc) const {
+    if (mainFile_) {
+        return mainFile_->contains(loc);
+    }
     if (loc.isInvalid()) {
         return false;
     }
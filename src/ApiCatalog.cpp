@@ -0,0 +1,140 @@
+﻿// Tough C Profiler - Allocation API Catalog Implementation
+// Tough C 分析器 - 分配 API 目录实现
+
+#include "tcc/ApiCatalog.h"
+
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/Decl.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include <algorithm>
+#include <iterator>
+#include <tuple>
+
+namespace tcc {
+
+namespace {
+
+// Operator entry names, in Lookup::operators_ order / 运算符条目名，按 Lookup::operators_ 的顺序
+constexpr const char* OPERATOR_NAMES[] = {
+    "operator new", "operator new[]", "operator delete", "operator delete[]"
+};
+
+// Index into Lookup::operators_, or -1 / Lookup::operators_ 的下标，或 -1
+int operatorIndex(clang::OverloadedOperatorKind kind) {
+    switch (kind) {
+        case clang::OO_New:
+            return 0;
+        case clang::OO_Array_New:
+            return 1;
+        case clang::OO_Delete:
+            return 2;
+        case clang::OO_Array_Delete:
+            return 3;
+        default:
+            return -1;
+    }
+}
+
+} // namespace
+
+ApiCatalog::ApiCatalog() {
+    for (const char* name : {"malloc", "calloc", "realloc", "reallocarray", "aligned_alloc",
+                             "posix_memalign", "memalign", "valloc", "pvalloc",
+                             "strdup", "strndup", "wcsdup", "mmap", "_aligned_malloc",
+                             "operator new", "operator new[]"}) {
+        add(name, ApiKind::Allocation);
+    }
+    for (const char* name : {"free", "munmap", "_aligned_free",
+                             "operator delete", "operator delete[]"}) {
+        add(name, ApiKind::Deallocation);
+    }
+}
+
+const ApiCatalog& ApiCatalog::builtin() {
+    static const ApiCatalog catalog;
+    return catalog;
+}
+
+void ApiCatalog::add(const std::string& name, ApiKind kind) {
+    entries_[name] = kind;
+}
+
+bool ApiCatalog::load(const std::string& path, std::string& error) {
+    auto buffer = llvm::MemoryBuffer::getFile(path, /*IsText=*/true);
+    if (!buffer) {
+        error = path + ": " + buffer.getError().message();
+        return false;
+    }
+    
+    llvm::StringRef rest = (*buffer)->getBuffer();
+    size_t lineNumber = 0;
+    while (!rest.empty()) {
+        llvm::StringRef line;
+        std::tie(line, rest) = rest.split('\n');
+        ++lineNumber;
+        line = line.trim();
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+        
+        size_t space = line.find_first_of(" \t");
+        llvm::StringRef keyword = line.substr(0, space);
+        llvm::StringRef name = line.substr(space).trim();
+        ApiKind kind = keyword == "alloc"   ? ApiKind::Allocation
+                     : keyword == "release" ? ApiKind::Deallocation
+                     : keyword == "allow"   ? ApiKind::Sanctioned
+                                            : ApiKind::None;
+        if (kind == ApiKind::None || name.empty()) {
+            error = path + ":" + std::to_string(lineNumber) +
+                    ": expected 'alloc', 'release' or 'allow' and a name / "
+                    "应为 'alloc'、'release' 或 'allow' 加名称";
+            return false;
+        }
+        add(name.str(), kind);
+    }
+    return true;
+}
+
+std::string ApiCatalog::getSignature() const {
+    std::string signature;
+    for (const auto& entry : entries_) {
+        signature += std::to_string(static_cast<int>(entry.second));
+        signature += entry.first;
+        signature += ';';
+    }
+    return signature;
+}
+
+// ApiCatalog::Lookup Implementation / ApiCatalog::Lookup 实现
+
+ApiCatalog::Lookup::Lookup(const ApiCatalog& catalog, const clang::ASTContext& context) {
+    for (const auto& entry : catalog.entries_) {
+        const auto* first = std::begin(OPERATOR_NAMES);
+        const auto* found = std::find(first, std::end(OPERATOR_NAMES), entry.first);
+        if (found != std::end(OPERATOR_NAMES)) {
+            operators_[static_cast<size_t>(found - first)] = entry.second;
+            continue;
+        }
+        
+        // A name the TU never spelled cannot be called; find() leaves the
+        // shared table untouched / TU 中未出现的名称不可能被调用；find() 不修改共享的表
+        auto identifier = context.Idents.find(entry.first);
+        if (identifier != context.Idents.end()) {
+            identifiers_[identifier->getValue()] = entry.second;
+        }
+    }
+}
+
+ApiKind ApiCatalog::Lookup::classify(const clang::FunctionDecl& callee) const {
+    // Operators have no identifier / 运算符没有标识符
+    if (const clang::IdentifierInfo* name = callee.getIdentifier()) {
+        auto it = identifiers_.find(name);
+        return it != identifiers_.end() ? it->second : ApiKind::None;
+    }
+    int index = operatorIndex(callee.getOverloadedOperator());
+    return index >= 0 ? operators_[static_cast<size_t>(index)] : ApiKind::None;
+}
+
+} // namespace tcc
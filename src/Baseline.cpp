@@ -0,0 +1,332 @@
+﻿// Tough C Profiler - Violation Baseline Implementation
+// Tough C 分析器 - 违规基线实现
+
+#include "tcc/Baseline.h"
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace tcc {
+
+namespace {
+
+constexpr const char* BASELINE_HEADER = "# tcc-baseline 1";
+constexpr size_t FINGERPRINT_DIGITS = 16;
+
+// 64-bit FNV-1a, continued from `hash` / 64 位 FNV-1a，从 `hash` 继续
+uint64_t fnv1a(std::string_view text, uint64_t hash = 14695981039346656037ull) {
+    for (char c : text) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Index key: the rule ID hashed on top of the fingerprint / 索引键：在指纹之上哈希规则 ID
+uint64_t baselineKey(std::string_view ruleId, uint64_t fingerprint) {
+    return fnv1a(ruleId, fingerprint);
+}
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v';
+}
+
+// Absolute, normalized directory of `path` / `path` 所在目录的规范化绝对路径
+std::string directoryOf(const std::string& path) {
+    llvm::SmallString<256> directory(path);
+    llvm::sys::fs::make_absolute(directory);
+    llvm::sys::path::remove_dots(directory, /*remove_dot_dot=*/true);
+    llvm::sys::path::remove_filename(directory);
+    return std::string(directory.str());
+}
+
+// `file` relative to `root` when inside it, with '/' separators
+// `file` 位于 `root` 内时转换为相对路径，使用 '/' 分隔
+std::string relativeTo(const std::string& root, const std::string& file) {
+    llvm::SmallString<256> path(file);
+    llvm::sys::fs::make_absolute(path);
+    llvm::sys::path::remove_dots(path, /*remove_dot_dot=*/true);
+    
+    llvm::StringRef relative = path.str();
+    if (!root.empty() && relative.startswith(root) && relative.size() > root.size() &&
+        llvm::sys::path::is_separator(relative[root.size()])) {
+        relative = relative.drop_front(root.size() + 1);
+    }
+    return llvm::sys::path::convert_to_slash(relative);
+}
+
+// Parse exactly 16 hex digits / 解析恰好 16 位十六进制数
+bool parseFingerprint(llvm::StringRef text, uint64_t& value) {
+    if (text.size() < FINGERPRINT_DIGITS) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = 0; i < FINGERPRINT_DIGITS; ++i) {
+        char c = text[i];
+        unsigned digit;
+        if (c >= '0' && c <= '9') {
+            digit = static_cast<unsigned>(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            digit = static_cast<unsigned>(c - 'a' + 10);
+        } else {
+            return false;
+        }
+        value = (value << 4) | digit;
+    }
+    return true;
+}
+
+} // namespace
+
+// SourceTextCache Implementation / SourceTextCache 实现
+
+SourceTextCache::SourceTextCache() = default;
+SourceTextCache::~SourceTextCache() = default;
+
+std::string SourceTextCache::getLine(StringId file, unsigned line) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto inserted = files_.try_emplace(file);
+    File& entry = inserted.first->second;
+    if (inserted.second) {
+        auto buffer = llvm::MemoryBuffer::getFile(StringPool::global().get(file),
+                                                  /*IsText=*/false,
+                                                  /*RequiresNullTerminator=*/false);
+        if (buffer) {
+            entry.buffer = std::move(*buffer);
+            llvm::StringRef text = entry.buffer->getBuffer();
+            entry.lineStarts.push_back(0);
+            for (size_t i = 0; i < text.size(); ++i) {
+                if (text[i] == '\n') {
+                    entry.lineStarts.push_back(static_cast<uint32_t>(i + 1));
+                }
+            }
+        }
+    }
+    
+    if (!entry.buffer || line == 0 || line > entry.lineStarts.size()) {
+        return std::string();
+    }
+    llvm::StringRef text = entry.buffer->getBuffer();
+    size_t begin = entry.lineStarts[line - 1];
+    size_t end = line < entry.lineStarts.size() ? entry.lineStarts[line] : text.size();
+    return text.slice(begin, end).str();
+}
+
+BaselineEntry computeBaselineEntry(const Diagnostic& diag, const std::string& root,
+                                   SourceTextCache& sources) {
+    const auto& location = diag.getLocation();
+    BaselineEntry entry;
+    entry.file = relativeTo(root, location.getFilename());
+    
+    uint64_t hash = fnv1a(entry.file);
+    for (auto argument : diag.getArguments()) {
+        hash = fnv1a(std::string_view("\0", 1), hash);
+        hash = fnv1a(argument, hash);
+    }
+    
+    // Whitespace is dropped so reindenting keeps the fingerprint
+    // 去除空白，重新缩进不会改变指纹
+    for (unsigned offset = 0; offset < 3; ++offset) {
+        hash = fnv1a("\n", hash);
+        for (char c : sources.getLine(location.file, location.line + offset - 1)) {
+            if (!isSpace(c)) {
+                hash = fnv1a(std::string_view(&c, 1), hash);
+            }
+        }
+    }
+    entry.fingerprint = hash;
+    return entry;
+}
+
+// Baseline Implementation / Baseline 实现
+
+bool Baseline::load(const std::string& path, std::string& error) {
+    auto buffer = llvm::MemoryBuffer::getFile(path, /*IsText=*/false,
+                                              /*RequiresNullTerminator=*/false);
+    if (!buffer) {
+        error = path + ": " + buffer.getError().message();
+        return false;
+    }
+    
+    llvm::StringRef text = (*buffer)->getBuffer();
+    if (!text.startswith(BASELINE_HEADER)) {
+        error = path + ": not a TCC baseline / 不是 TCC 基线文件";
+        return false;
+    }
+    
+    root_ = directoryOf(path);
+    keys_.clear();
+    keys_.reserve(static_cast<size_t>(std::count(text.begin(), text.end(), '\n')) + 1);
+    
+    // Plain memchr scan; no per-line allocation / 直接 memchr 扫描；每行无内存分配
+    const char* next = text.begin();
+    const char* end = text.end();
+    size_t lineNumber = 0;
+    while (next < end) {
+        const char* eol = static_cast<const char*>(std::memchr(next, '\n', end - next));
+        if (!eol) {
+            eol = end;
+        }
+        llvm::StringRef line(next, static_cast<size_t>(eol - next));
+        next = eol + 1;
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') {
+            line = line.drop_back();
+        }
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+        
+        uint64_t fingerprint = 0;
+        if (!parseFingerprint(line, fingerprint) || line.size() <= FINGERPRINT_DIGITS ||
+            line[FINGERPRINT_DIGITS] != ' ') {
+            error = path + ":" + std::to_string(lineNumber) +
+                    ": malformed entry / 条目格式错误";
+            return false;
+        }
+        llvm::StringRef ruleId = line.drop_front(FINGERPRINT_DIGITS + 1);
+        ruleId = ruleId.take_until([](char c) { return c == ' '; });
+        keys_.insert(baselineKey(std::string_view(ruleId.data(), ruleId.size()), fingerprint));
+    }
+    return true;
+}
+
+bool Baseline::contains(const Diagnostic& diag) const {
+    if (keys_.size() == 0) {
+        return false;
+    }
+    BaselineEntry entry = computeBaselineEntry(diag, root_, sources_);
+    return keys_.contains(baselineKey(diag.getRuleId(), entry.fingerprint));
+}
+
+size_t Baseline::filter(DiagnosticEngine& diagnostics) const {
+    return diagnostics.removeIf([this](const Diagnostic& diag) { return contains(diag); });
+}
+
+// Baseline::KeySet Implementation / Baseline::KeySet 实现
+
+void Baseline::KeySet::reserve(size_t count) {
+    // At most half full keeps probe chains short / 至多半满，使探测链保持较短
+    size_t capacity = 16;
+    while (capacity < count * 2) {
+        capacity *= 2;
+    }
+    if (capacity <= slots_.size()) {
+        return;
+    }
+    
+    std::vector<uint64_t> old;
+    old.swap(slots_);
+    slots_.assign(capacity, 0);
+    size_ = 0;
+    for (uint64_t key : old) {
+        if (key != 0) {
+            insert(key);
+        }
+    }
+}
+
+void Baseline::KeySet::insert(uint64_t key) {
+    if ((size_ + 1) * 2 > slots_.size()) {
+        reserve(size_ + 1);
+    }
+    
+    // 0 marks empty slots; folding it onto 1 costs one key in 2^64
+    // 0 标记空槽；将其并入 1 只损失 2^64 分之一的键
+    key = key ? key : 1;
+    size_t mask = slots_.size() - 1;
+    for (size_t slot = static_cast<size_t>(key) & mask;; slot = (slot + 1) & mask) {
+        if (slots_[slot] == key) {
+            return;
+        }
+        if (slots_[slot] == 0) {
+            slots_[slot] = key;
+            ++size_;
+            return;
+        }
+    }
+}
+
+bool Baseline::KeySet::contains(uint64_t key) const {
+    if (slots_.empty()) {
+        return false;
+    }
+    key = key ? key : 1;
+    size_t mask = slots_.size() - 1;
+    for (size_t slot = static_cast<size_t>(key) & mask;; slot = (slot + 1) & mask) {
+        if (slots_[slot] == key) {
+            return true;
+        }
+        if (slots_[slot] == 0) {
+            return false;
+        }
+    }
+}
+
+void Baseline::KeySet::clear() {
+    std::vector<uint64_t>().swap(slots_);
+    size_ = 0;
+}
+
+// BaselineWriter Implementation / BaselineWriter 实现
+
+BaselineWriter::BaselineWriter(std::string path)
+    : path_(std::move(path))
+    , root_(directoryOf(path_)) {}
+
+void BaselineWriter::handle(const Diagnostic& diag) {
+    BaselineEntry entry = computeBaselineEntry(diag, root_, sources_);
+    
+    std::string line;
+    llvm::raw_string_ostream os(line);
+    os << llvm::format_hex_no_prefix(entry.fingerprint, FINGERPRINT_DIGITS)
+       << ' ' << diag.getRuleId() << ' ' << entry.file;
+    os.flush();
+    lines_.push_back(std::move(line));
+}
+
+void BaselineWriter::finish() {
+    // Sorted and unique so the file diffs cleanly / 排序并去重，便于比较差异
+    std::sort(lines_.begin(), lines_.end());
+    lines_.erase(std::unique(lines_.begin(), lines_.end()), lines_.end());
+    entryCount_ = lines_.size();
+    
+    // Write to a private temp file, then rename into place
+    // 先写私有临时文件再重命名到位
+    int fd = -1;
+    llvm::SmallString<256> tempPath;
+    if (std::error_code ec = llvm::sys::fs::createUniqueFile(path_ + "-%%%%%%%%.tmp", fd, tempPath)) {
+        error_ = path_ + ": " + ec.message();
+        return;
+    }
+    
+    {
+        llvm::raw_fd_ostream file(fd, /*shouldClose=*/true);
+        file << BASELINE_HEADER << '\n';
+        for (const auto& line : lines_) {
+            file << line << '\n';
+        }
+        file.close();
+        if (file.has_error()) {
+            error_ = path_ + ": " + file.error().message();
+            file.clear_error();
+            llvm::sys::fs::remove(tempPath);
+            return;
+        }
+    }
+    std::vector<std::string>().swap(lines_);
+    
+    if (std::error_code ec = llvm::sys::fs::rename(tempPath, path_)) {
+        error_ = path_ + ": " + ec.message();
+        llvm::sys::fs::remove(tempPath);
+    }
+}
+
+} // namespace tcc
@@ -0,0 +1,536 @@
+﻿// Tough C Profiler - Check Command Implementation
+// Tough C 分析器 - 检查命令实现
+
+#include "tcc/CheckCommand.h"
+#include "tcc/ApiCatalog.h"
+#include "tcc/Baseline.h"
+#include "tcc/Core.h"
+#include "tcc/Diagnostic.h"
+#include "tcc/Driver.h"
+#include "tcc/FileDetector.h"
+#include "tcc/OutputFormat.h"
+#include "tcc/RuleEngine.h"
+#include "tcc/ShardFile.h"
+#include "tcc/TimeReport.h"
+#include "tcc/Watcher.h"
+
+#include <clang/Tooling/CommonOptionsParser.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <functional>
+#include <string>
+
+using namespace clang;
+using namespace clang::tooling;
+using namespace llvm;
+
+namespace tcc {
+
+namespace {
+
+// Command line options / 命令行选项
+cl::OptionCategory TCCCategory("Tough C Options / Tough C 选项");
+
+cl::opt<bool> ShowVersion(
+    "version",
+    cl::desc("Show version information / 显示版本信息"),
+    cl::cat(TCCCategory)
+);
+
+cl::opt<bool> Verbose(
+    "verbose",
+    cl::desc("Enable verbose output / 启用详细输出"),
+    cl::cat(TCCCategory)
+);
+
+cl::opt<bool> NoOwnership(
+    "no-ownership",
+    cl::desc("Disable ownership checks / 禁用所有权检查"),
+    cl::cat(TCCCategory)
+);
+
+cl::opt<bool> NoLifetime(
+    "no-lifetime",
+    cl::desc("Disable lifetime checks / 禁用生命周期检查"),
+    cl::cat(TCCCategory)
+);
+
+cl::opt<bool> NoConcurrency(
+    "no-concurrency",
+    cl::desc("Disable concurrency checks / 禁用并发检查"),
+    cl::cat(TCCCategory)
+);
+
+cl::opt<unsigned> Jobs(
+    "j",
+    cl::desc("Number of translation units checked in parallel, 0 = all cores / "
+             "并行检查的翻译单元数，0 = 所有核心"),
+    cl::value_desc("N"),
+    cl::init(1),
+    cl::cat(TCCCategory)
+);
+
+cl::opt<unsigned> TUThreads(
+    "tu-threads",
+    cl::desc("Split the rule checks of each parsed translation unit across N threads / "
+             "将每个已解析翻译单元的规则检查拆分到 N 个线程"),
+    cl::value_desc("N"),
+    cl::init(1),
+    cl::cat(TCCCategory)
+);
+
+cl::opt<std::string> CacheDir(
+    "cache-dir",
+    cl::desc("Cache per-TU results in this directory / 在此目录中缓存每个翻译单元的结果"),
+    cl::value_desc("dir"),
+    cl::cat(TCCCategory)
+);
+
+cl::opt<unsigned> CacheSizeMB(
+    "cache-size-mb",
+    cl::desc("Result cache size cap in MiB (default 512) / 结果缓存大小上限（MiB，默认 512）"),
+    cl::value_desc("N"),
+    cl::init(512),
+    cl::cat(TCCCategory)
+);
+
+cl::opt<bool> Watch(
+    "watch",
+    cl::desc("Keep running and re-check files affected by changes / 持续运行并重新检查受变更影响的文件"),
+    cl::cat(TCCCategory)
+);
+
+cl::opt<bool> TimeReportTable(
+    "time-report",
+    cl::desc("Print wall/CPU time per phase and per rule / 打印每个阶段和每条规则的墙钟/CPU 时间"),
+    cl::cat(TCCCategory)
+);
+
+cl::opt<std::string> TimeReportJSON(
+    "time-report-json",
+    cl::desc("Write the time report as JSON to this file / 将时间报告以 JSON 写入此文件"),
+    cl::value_desc("file"),
+    cl::cat(TCCCategory)
+);
+
+cl::opt<bool> UseSharedPCH(
+    "pch",
+    cl::desc("Precompile the include prefix shared per flag set (needs --cache-dir) / "
+             "按标志集预编译共享的包含前缀（需要 --cache-dir）"),
+    cl::cat(TCCCategory)
+);
+
+cl::opt<Locale> OutputLocale(
+    "locale",
+    cl::desc("Language of diagnostic text / 诊断文本的语言"),
+    cl::values(
+        clEnumValN(Locale::Bilingual, "both", "English and Chinese (default) / 英文和中文（默认）"),
+        clEnumValN(Locale::English, "en", "English only / 仅英文"),
+        clEnumValN(Locale::Chinese, "zh", "Chinese only / 仅中文")),
+    cl::init(Locale::Bilingual),
+    cl::cat(TCCCategory)
+);
+
+cl::opt<OutputFormat> Format(
+    "format",
+    cl::desc("Diagnostic output format; sarif and jsonl go to stdout / "
+             "诊断输出格式；sarif 和 jsonl 写到标准输出"),
+    cl::values(
+        clEnumValN(OutputFormat::Text, "text", "Human-readable (default) / 人类可读（默认）"),
+        clEnumValN(OutputFormat::SARIF, "sarif", "SARIF 2.1.0"),
+        clEnumValN(OutputFormat::JSONLines, "jsonl", "One JSON object per line / 每行一个 JSON 对象")),
+    cl::init(OutputFormat::Text),
+    cl::cat(TCCCategory)
+);
+
+cl::opt<std::string> ShardOutput(
+    "shard-output",
+    cl::desc("Also write results as a binary shard for tcc-merge / 同时将结果写为供 tcc-merge 使用的二进制分片"),
+    cl::value_desc("file"),
+    cl::cat(TCCCategory)
+);
+
+cl::opt<bool> Stream(
+    "stream",
+    cl::desc("Print each file's diagnostics as soon as it and every earlier file are checked / "
+             "每个文件及之前所有文件检查完成后立即打印其诊断"),
+    cl::cat(TCCCategory)
+);
+
+cl::opt<bool> FailFast(
+    "fail-fast",
+    cl::desc("Stop checking at the first error; remaining files are not parsed / "
+             "遇到第一个错误即停止检查；其余文件不再解析"),
+    cl::cat(TCCCategory)
+);
+
+cl::opt<bool> Gate(
+    "gate",
+    cl::desc("Pass/fail gate: skip expensive rules in files cheaper rules already rejected / "
+             "通过/失败门禁：对已被较廉价规则拒绝的文件跳过昂贵规则"),
+    cl::cat(TCCCategory)
+);
+
+cl::opt<std::string> BaselineFile(
+    "baseline",
+    cl::desc("Report only violations not accepted in this baseline file / 只报告此基线文件中未接受的违规"),
+    cl::value_desc("file"),
+    cl::cat(TCCCategory)
+);
+
+cl::opt<std::string> WriteBaseline(
+    "write-baseline",
+    cl::desc("Accept every current violation into this baseline file and exit / "
+             "将当前所有违规接受到此基线文件中并退出"),
+    cl::value_desc("file"),
+    cl::cat(TCCCategory)
+);
+
+cl::opt<std::string> ApiCatalogFile(
+    "api-catalog",
+    cl::desc("Add allocation APIs to forbid or allow from this file / 从此文件添加要禁止或允许的分配 API"),
+    cl::value_desc("file"),
+    cl::cat(TCCCategory)
+);
+
+cl::list<std::string> LoadPlugins(
+    "load",
+    cl::desc("Load rule plugins from this shared library (repeatable) / 从此共享库加载规则插件（可重复）"),
+    cl::value_desc("plugin"),
+    cl::cat(TCCCategory)
+);
+
+// Print banner / 打印横幅
+void printBanner(raw_ostream& out) {
+    out << "╔════════════════════════════════════════════════════════════╗\n";
+    out << "║  Tough C Profiler - Pre-compilation Safety Analyzer       ║\n";
+    out << "║  Tough C 分析器 - 预编译安全分析工具                       ║\n";
+    out << "║  Version / 版本: " << VERSION << "                                   ║\n";
+    out << "╚════════════════════════════════════════════════════════════╝\n\n";
+}
+
+void printViolationHeader(raw_ostream& err) {
+    err << "\n✗ TCC rule violations found:\n";
+    err << "✗ 发现 TCC 规则违规:\n\n";
+}
+
+// Human output keeps the banner and summaries; machine formats own stdout
+// 人类可读输出保留横幅和摘要；机器格式独占标准输出
+bool isTextFormat() {
+    return Format == OutputFormat::Text;
+}
+
+// Sink for --format, writing where that format belongs / --format 对应的接收器，写到该格式所属的流
+std::unique_ptr<DiagnosticSink> createSink(raw_ostream& out, raw_ostream& err) {
+    return createOutputSink(Format, isTextFormat() ? err : out, OutputLocale);
+}
+
+// Writes each TU's output as soon as it finishes and releases it, so memory
+// stays bounded by the TUs in flight
+// 每个翻译单元完成后立即写出并释放其输出，内存仅受正在处理的翻译单元限制
+class StreamingReport {
+public:
+    StreamingReport(raw_ostream& err, DiagnosticSink& sink) : err_(err), sink_(sink) {}
+    
+    void operator()(TUResult& result) {
+        err_ << result.compilerOutput;
+        std::string().swap(result.compilerOutput);
+        
+        if (!result.diagnostics.getDiagnostics().empty() && !headerPrinted_ && isTextFormat()) {
+            printViolationHeader(err_);
+            headerPrinted_ = true;
+        }
+        result.diagnostics.flush(sink_);
+        err_.flush();
+    }
+
+private:
+    raw_ostream& err_;
+    DiagnosticSink& sink_;
+    bool headerPrinted_ = false;
+};
+
+// Print per-TU results in input order through `sink`; returns the exit code.
+// Streamed results only contribute their counts.
+// 通过 `sink` 按输入顺序打印各翻译单元的结果；返回退出码。已流式输出的结果只贡献计数。
+int printReport(const std::vector<TUResult>& results, raw_ostream& out, raw_ostream& err,
+                DiagnosticSink& sink, bool streamed) {
+    size_t diagnosticCount = 0;
+    size_t errorCount = 0;
+    size_t cancelledCount = 0;
+    size_t baselinedCount = 0;
+    for (const auto& result : results) {
+        err << result.compilerOutput;
+        diagnosticCount += result.diagnostics.getDiagnosticCount();
+        errorCount += result.diagnostics.getErrorCount();
+        cancelledCount += result.cancelled ? 1 : 0;
+        baselinedCount += result.baselined;
+    }
+    
+    // Print diagnostics / 打印诊断
+    if (!streamed) {
+        if (diagnosticCount > 0 && isTextFormat()) {
+            printViolationHeader(err);
+        }
+        for (const auto& result : results) {
+            for (const auto& diag : result.diagnostics.getDiagnostics()) {
+                sink.handle(diag);
+            }
+        }
+    }
+    sink.finish();
+    
+    if (baselinedCount > 0 && isTextFormat()) {
+        err << "\nBaseline: " << baselinedCount << " known violation(s) not reported\n";
+        err << "基线：" << baselinedCount << " 个已知违规未报告\n";
+    }
+    
+    if (diagnosticCount == 0) {
+        if (isTextFormat()) {
+            out << "\n✓ All checks passed! Code is TCC-compliant.\n";
+            out << "✓ 所有检查通过！代码符合 TCC 规范。\n";
+        }
+        return static_cast<int>(ExitCode::Success);
+    }
+    
+    if (errorCount > 0) {
+        if (cancelledCount > 0 && FailFast && isTextFormat()) {
+            err << "\nStopped at the first error (--fail-fast); files not fully checked: "
+                << cancelledCount << "\n";
+            err << "在第一个错误处停止（--fail-fast）；未完整检查的文件数: " << cancelledCount << "\n";
+        }
+        err << "\nErrors: " << errorCount << "\n";
+        err << "错误数: " << errorCount << "\n";
+        return static_cast<int>(ExitCode::RuleViolation);
+    }
+    
+    return static_cast<int>(ExitCode::Success);
+}
+
+// Accept every diagnostic of `results` into the --write-baseline file
+// 将 `results` 的所有诊断接受到 --write-baseline 文件中
+int writeBaseline(std::vector<TUResult>& results, raw_ostream& out, raw_ostream& err) {
+    BaselineWriter writer(WriteBaseline);
+    for (auto& result : results) {
+        err << result.compilerOutput;
+        result.diagnostics.flush(writer);
+    }
+    writer.finish();
+    
+    if (!writer.getError().empty()) {
+        err << "Cannot write baseline / 无法写入基线: " << writer.getError() << "\n";
+        return static_cast<int>(ExitCode::InternalError);
+    }
+    out << "Baseline written / 基线已写入: " << WriteBaseline
+        << " (" << writer.getEntryCount() << " entries / 条)\n";
+    return static_cast<int>(ExitCode::Success);
+}
+
+// Print the time report in the requested formats / 以请求的格式打印时间报告
+void emitTimeReport(TimeReport& timeReport, const Stopwatch& elapsed, raw_ostream& err) {
+    timeReport.setElapsed(elapsed.wallSeconds());
+    if (TimeReportTable) {
+        timeReport.printTable(err);
+    }
+    if (!TimeReportJSON.empty()) {
+        std::error_code ec;
+        raw_fd_ostream json(TimeReportJSON, ec);
+        if (ec) {
+            err << "Cannot write time report / 无法写入时间报告: " << TimeReportJSON
+                << ": " << ec.message() << "\n";
+            return;
+        }
+        timeReport.printJSON(json);
+    }
+}
+
+} // namespace
+
+int runCheckCommand(int argc, const char** argv, raw_ostream& out, raw_ostream& err,
+                    CancellationToken* cancel) {
+    Stopwatch elapsed;
+    TimeReport timeReport;
+    
+    // Parse command line / 解析命令行
+    auto ExpectedParser = CommonOptionsParser::create(
+        argc, argv, TCCCategory,
+        cl::Optional,
+        "Tough C Profiler - enforces safety rules on C/C++ code\n"
+        "Tough C 分析器 - 对 C/C++ 代码强制执行安全规则"
+    );
+    
+    if (!ExpectedParser) {
+        err << "Error parsing command line arguments:\n";
+        err << "命令行参数解析错误:\n";
+        err << toString(ExpectedParser.takeError()) << "\n";
+        return static_cast<int>(ExitCode::InvalidArguments);
+    }
+    
+    CommonOptionsParser& OptionsParser = ExpectedParser.get();
+    timeReport.addPhase("options", elapsed);
+    bool timing = TimeReportTable || !TimeReportJSON.empty();
+    
+    // Show version if requested / 如果请求则显示版本
+    if (ShowVersion) {
+        printBanner(out);
+        return static_cast<int>(ExitCode::Success);
+    }
+    
+    // Progress and verbose output stay off stdout for machine formats
+    // 机器格式下进度和详细输出不写入标准输出
+    raw_ostream& log = isTextFormat() ? out : err;
+    if (isTextFormat()) {
+        printBanner(out);
+    }
+    
+    // Configure the batch / 配置批量运行
+    DriverOptions options;
+    options.jobs = Jobs;
+    options.tuThreads = TUThreads;
+    options.verbose = Verbose;
+    options.cacheDirectory = CacheDir;
+    options.cacheMaxBytes = static_cast<uint64_t>(CacheSizeMB) << 20;
+    options.sharedPCH = UseSharedPCH;
+    options.recordDependencies = Watch;
+    options.timeReport = timing ? &timeReport : nullptr;
+    options.failFast = FailFast;
+    options.gate = Gate;
+    options.cancel = cancel;
+    
+    // Writing a baseline records everything, so an old one is not applied
+    // 写基线时记录全部违规，因此不应用旧基线
+    Baseline baseline;
+    if (!BaselineFile.empty() && WriteBaseline.empty()) {
+        Stopwatch stopwatch;
+        std::string error;
+        if (!baseline.load(BaselineFile, error)) {
+            err << "Cannot read baseline / 无法读取基线: " << error << "\n";
+            return static_cast<int>(ExitCode::FileNotFound);
+        }
+        timeReport.addPhase("baseline", stopwatch);
+        options.baseline = &baseline;
+        if (Verbose) {
+            log << "Baseline entries: " << baseline.size() << "\n";
+            log << "基线条目数: " << baseline.size() << "\n";
+        }
+    }
+    
+    ApiCatalog apiCatalog;
+    if (!ApiCatalogFile.empty()) {
+        Stopwatch stopwatch;
+        std::string error;
+        if (!apiCatalog.load(ApiCatalogFile, error)) {
+            err << "Cannot read API catalog / 无法读取 API 目录: " << error << "\n";
+            return static_cast<int>(ExitCode::FileNotFound);
+        }
+        timeReport.addPhase("api-catalog", stopwatch);
+        options.apiCatalog = &apiCatalog;
+    }
+    
+    // Plugins register their rules while loading / 插件在加载时注册其规则
+    for (const auto& path : LoadPlugins) {
+        Stopwatch stopwatch;
+        std::string error;
+        const RulePlugin* plugin = RuleRegistry::instance().loadPlugin(path, error);
+        if (!plugin) {
+            err << "Cannot load plugin / 无法加载插件: " << error << "\n";
+            return static_cast<int>(ExitCode::FileNotFound);
+        }
+        timeReport.addPhase("plugins", stopwatch);
+        options.plugins.push_back(plugin);
+        if (Verbose) {
+            log << "Plugin rules: " << plugin->factories.size() << " from " << path << "\n";
+            log << "插件规则数: " << plugin->factories.size() << "（来自 " << path << "）\n";
+        }
+    }
+    
+    if (UseSharedPCH && CacheDir.empty()) {
+        err << "--pch requires --cache-dir\n";
+        err << "--pch 需要 --cache-dir\n";
+        return static_cast<int>(ExitCode::InvalidArguments);
+    }
+    
+    // Configure rule categories / 配置规则类别
+    if (NoOwnership) {
+        options.ownershipChecks = false;
+        if (Verbose) {
+            log << "Ownership checks disabled\n";
+            log << "所有权检查已禁用\n";
+        }
+    }
+    if (NoLifetime) {
+        options.lifetimeChecks = false;
+        if (Verbose) {
+            log << "Lifetime checks disabled\n";
+            log << "生命周期检查已禁用\n";
+        }
+    }
+    if (NoConcurrency) {
+        options.concurrencyChecks = false;
+        if (Verbose) {
+            log << "Concurrency checks disabled\n";
+            log << "并发检查已禁用\n";
+        }
+    }
+    
+    if (Verbose) {
+        auto engine = Driver::createEngine(options);
+        log << "Active rules: " << engine->getActiveRuleCount() << "\n";
+        log << "活动规则数: " << engine->getActiveRuleCount() << "\n\n";
+    }
+    
+    // Run tool / 运行工具
+    Driver driver(OptionsParser.getCompilations(), options, log);
+    if (Watch) {
+        Watcher watcher(driver, OptionsParser.getCompilations(), err);
+        return watcher.run(OptionsParser.getSourcePathList(),
+                           [&](const std::vector<TUResult>& results) {
+            Stopwatch output;
+            auto sink = createSink(out, err);
+            printReport(results, out, err, *sink, /*streamed=*/false);
+            if (timing) {
+                timeReport.addPhase("output", output);
+                emitTimeReport(timeReport, elapsed, err);
+            }
+            out.flush();
+            err.flush();
+        });
+    }
+    
+    if (!WriteBaseline.empty()) {
+        auto results = driver.run(OptionsParser.getSourcePathList());
+        return writeBaseline(results, log, err);
+    }
+    
+    auto report = createSink(out, err);
+    std::vector<DiagnosticSink*> sinks = {report.get()};
+    std::unique_ptr<ShardWriter> shardWriter;
+    if (!ShardOutput.empty()) {
+        shardWriter = std::make_unique<ShardWriter>(ShardOutput);
+        sinks.push_back(shardWriter.get());
+    }
+    TeeDiagnosticSink sink(std::move(sinks));
+    
+    std::vector<TUResult> results;
+    if (Stream) {
+        StreamingReport streaming(err, sink);
+        results = driver.run(OptionsParser.getSourcePathList(), std::ref(streaming));
+    } else {
+        results = driver.run(OptionsParser.getSourcePathList());
+    }
+    
+    Stopwatch output;
+    int exitCode = printReport(results, out, err, sink, Stream);
+    if (shardWriter && !shardWriter->getError().empty()) {
+        err << "Cannot write shard / 无法写入分片: " << shardWriter->getError() << "\n";
+        exitCode = static_cast<int>(ExitCode::InternalError);
+    }
+    if (timing) {
+        timeReport.addPhase("output", output);
+        emitTimeReport(timeReport, elapsed, err);
+    }
+    return exitCode;
+}
+
+} // namespace tcc
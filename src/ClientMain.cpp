@@ -0,0 +1,106 @@
+﻿// Tough C Profiler - Check Client
+// Tough C 分析器 - 检查客户端
+//
+// Drop-in replacement for tcc-check that forwards to tcc-checkd,
+// falling back to tcc-check when no daemon is running
+// tcc-check 的直接替代品，转发给 tcc-checkd；无守护进程时回退到 tcc-check
+
+#include "tcc/Core.h"
+#include "tcc/DaemonProtocol.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace tcc;
+
+namespace {
+
+// Help output comes from LLVM, which the client does not link, and
+// --watch would hold the daemon forever
+// 帮助输出来自 LLVM，而客户端不链接 LLVM；--watch 会永久占用守护进程
+bool mustRunLocally(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        while (*arg == '-') {
+            ++arg;
+        }
+        if (std::strncmp(arg, "help", 4) == 0 || std::strncmp(arg, "print-", 6) == 0 ||
+            std::strcmp(arg, "watch") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int connectDaemon() {
+    std::string path = getDaemonSocketPath();
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        return -1;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool writeStream(FILE* stream, const std::string& text) {
+    return std::fwrite(text.data(), 1, text.size(), stream) == text.size();
+}
+
+// Run the in-process CLI with the same arguments / 以相同参数运行进程内 CLI
+int runLocally(char** argv) {
+    char name[] = "tcc-check";
+    argv[0] = name;
+    ::execvp(name, argv);
+    std::fprintf(stderr, "tcc-check-client: cannot run tcc-check: %s\n", std::strerror(errno));
+    return static_cast<int>(ExitCode::InternalError);
+}
+
+} // namespace
+
+// Main function / 主函数
+int main(int argc, char** argv) {
+    int fd = mustRunLocally(argc, argv) ? -1 : connectDaemon();
+    if (fd < 0) {
+        return runLocally(argv);
+    }
+    
+    CheckRequest request;
+    char cwd[4096];
+    if (!::getcwd(cwd, sizeof(cwd))) {
+        ::close(fd);
+        return runLocally(argv);
+    }
+    request.workingDirectory = cwd;
+    request.args.assign(argv + 1, argv + argc);
+    
+    CheckResponse response;
+    bool ok = writeRequest(fd, request) && readResponse(fd, response);
+    ::close(fd);
+    if (!ok) {
+        std::fprintf(stderr, "tcc-check-client: lost connection to tcc-checkd\n");
+        std::fprintf(stderr, "tcc-check-client: 与 tcc-checkd 的连接中断\n");
+        return static_cast<int>(ExitCode::InternalError);
+    }
+    
+    writeStream(stdout, response.out);
+    std::fflush(stdout);
+    writeStream(stderr, response.err);
+    return response.exitCode;
+}
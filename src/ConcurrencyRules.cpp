@@ -2,160 +2,79 @@
 // Tough C 分析器 - 并发规则实现
 
 #include "tcc/ConcurrencyRules.h"
-#include <clang/AST/RecursiveASTVisitor.h>
 #include <clang/AST/ASTContext.h>
 #include <clang/Basic/SourceManager.h>
 
+using namespace clang::ast_matchers;
+
 namespace tcc {
 
 // ForbidUnsyncSharedStateRule Implementation
 
-class UnsyncSharedStateFinder : public clang::RecursiveASTVisitor<UnsyncSharedStateFinder> {
-public:
-    explicit UnsyncSharedStateFinder(ForbidUnsyncSharedStateRule* rule,
-                                    clang::ASTContext& context,
-                                    DiagnosticEngine& diagnostics)
-        : rule_(rule), context_(context), diagnostics_(diagnostics) {}
-    
-    bool VisitVarDecl(clang::VarDecl* decl) {
-        if (!decl || !isInMainFile(decl->getLocation())) {
-            return true;
-        }
-        
-        if (rule_->isMutableSharedState(decl)) {
-            reportViolation(decl);
-        }
-        
-        return true;
-    }
-    
-private:
-    bool isInMainFile(clang::SourceLocation loc) const {
-        return context_.getSourceManager().isInMainFile(loc);
-    }
-    
-    void reportViolation(clang::VarDecl* decl) {
-        const auto& sm = context_.getSourceManager();
-        auto loc = decl->getLocation();
-        auto presumedLoc = sm.getPresumedLoc(loc);
-        
-        SourceLocation srcLoc(presumedLoc.getFilename(), presumedLoc.getLine(), presumedLoc.getColumn());
-        
-        Diagnostic diag(
-            Severity::Warning,
-            "Global/static mutable state without synchronization / "
-            "全局/静态可变状态没有同步",
-            srcLoc, RuleCategory::Concurrency, "TCC-CONC-001"
-        );
-        
-        diag.addFixHint("Use std::atomic<T> for simple types / 对简单类型使用 std::atomic<T>");
-        diag.addFixHint("Use std::mutex for complex state / 对复杂状态使用 std::mutex");
-        diag.addFixHint("Use thread_local for thread-specific state / 对线程特定状态使用 thread_local");
-        diag.addEscapePath("Document thread-safety explicitly / 明确记录线程安全性");
-        
-        diagnostics_.report(std::move(diag));
-    }
-    
-    ForbidUnsyncSharedStateRule* rule_;
-    clang::ASTContext& context_;
-    DiagnosticEngine& diagnostics_;
-};
-
-void ForbidUnsyncSharedStateRule::check(clang::ASTContext& context, DiagnosticEngine& diagnostics) {
-    UnsyncSharedStateFinder finder(this, context, diagnostics);
-    finder.TraverseDecl(context.getTranslationUnitDecl());
+void ForbidUnsyncSharedStateRule::registerMatchers(MatchFinder& finder,
+                                                   MatchFinder::MatchCallback* callback) {
+    // Global storage covers static locals / 全局存储包括静态局部变量
+    finder.addMatcher(
+        varDecl(hasGlobalStorage(), unless(hasType(isConstQualified()))).bind("var"),
+        callback);
 }
 
-bool ForbidUnsyncSharedStateRule::isMutableSharedState(clang::VarDecl* decl) const {
-    if (!decl) return false;
-    
-    // Check if global or static / 检查是否是全局或静态
-    bool isShared = decl->hasGlobalStorage() || decl->isStaticLocal();
-    if (!isShared) return false;
+void ForbidUnsyncSharedStateRule::onMatch(const MatchFinder::MatchResult& result,
+                                          const NodeHookContext& hook) {
+    const auto* decl = result.Nodes.getNodeAs<clang::VarDecl>("var");
     
-    // Check if mutable (not const) / 检查是否可变（非 const）
-    if (decl->getType().isConstQualified()) return false;
-    
-    // Check if it's atomic (safe) / 检查是否是 atomic（安全）
-    std::string typeName = decl->getType().getAsString();
-    if (typeName.find("atomic") != std::string::npos) return false;
-    if (typeName.find("mutex") != std::string::npos) return false;
-    
-    return true;
+    // Atomics, mutexes and other primitives synchronize themselves, also as arrays
+    // atomic、mutex 及其他同步原语自带同步，数组亦然
+    // getBaseElementTypeUnsafe builds no type nodes, so this is safe from shard threads
+    // getBaseElementTypeUnsafe 不创建类型节点，因此可在分片线程中安全调用
+    switch (hook.types.classify(clang::QualType(decl->getType()->getBaseElementTypeUnsafe(), 0))) {
+        case TypeClass::Atomic:
+        case TypeClass::Mutex:
+        case TypeClass::SyncPrimitive:
+            return;
+        default:
+            break;
+    }
+    report(hook.diagnostics, hook.context, decl->getLocation(),
+           Severity::Warning, MessageId::UnsyncSharedState);
 }
 
 // ForbidNonConstLambdaCaptureRule Implementation
 
-class NonConstLambdaCaptureFinder : public clang::RecursiveASTVisitor<NonConstLambdaCaptureFinder> {
-public:
-    explicit NonConstLambdaCaptureFinder(clang::ASTContext& context, DiagnosticEngine& diagnostics)
-        : context_(context), diagnostics_(diagnostics) {}
-    
-    bool VisitLambdaExpr(clang::LambdaExpr* lambda) {
-        if (!lambda || !isInMainFile(lambda->getLocation())) {
-            return true;
-        }
-        
-        // Check each capture / 检查每个捕获
-        for (auto capture : lambda->captures()) {
-            if (capture.capturesVariable()) {
-                auto* var = capture.getCapturedVar();
-                if (var && !var->getType().isConstQualified() && 
-                    capture.getCaptureKind() == clang::LCK_ByRef) {
-                    reportViolation(lambda, var);
-                }
+void ForbidNonConstLambdaCaptureRule::checkLambdaExpr(clang::LambdaExpr* lambda,
+                                                      clang::ASTContext& context,
+                                                      DiagnosticEngine& diagnostics) {
+    // Check each capture / 检查每个捕获
+    for (auto capture : lambda->captures()) {
+        if (capture.capturesVariable()) {
+            auto* var = capture.getCapturedVar();
+            if (var && !var->getType().isConstQualified() && 
+                capture.getCaptureKind() == clang::LCK_ByRef) {
+                reportViolation(lambda, context, diagnostics);
             }
         }
-        
-        return true;
     }
-    
-private:
-    bool isInMainFile(clang::SourceLocation loc) const {
-        return context_.getSourceManager().isInMainFile(loc);
-    }
-    
-    void reportViolation(clang::LambdaExpr* lambda, clang::VarDecl* var) {
-        const auto& sm = context_.getSourceManager();
-        auto loc = lambda->getLocation();
-        auto presumedLoc = sm.getPresumedLoc(loc);
-        
-        SourceLocation srcLoc(presumedLoc.getFilename(), presumedLoc.getLine(), presumedLoc.getColumn());
-        
-        Diagnostic diag(
-            Severity::Error,
-            "Lambda captures non-const reference (potential data race) / "
-            "Lambda 捕获非 const 引用（潜在数据竞争）",
-            srcLoc, RuleCategory::Concurrency, "TCC-CONC-002"
-        );
-        
-        diag.addFixHint("Capture by value instead: [=] / 改为按值捕获：[=]");
-        diag.addFixHint("Capture as const reference if read-only / 如果只读则捕获为 const 引用");
-        diag.addFixHint("Use std::atomic or mutex for shared state / 对共享状态使用 std::atomic 或 mutex");
-        diag.addEscapePath("Remove @tcc annotation / 移除 @tcc 注解");
-        
-        diagnostics_.report(std::move(diag));
-    }
-    
-    clang::ASTContext& context_;
-    DiagnosticEngine& diagnostics_;
-};
+}
 
-void ForbidNonConstLambdaCaptureRule::check(clang::ASTContext& context, DiagnosticEngine& diagnostics) {
-    NonConstLambdaCaptureFinder finder(context, diagnostics);
-    finder.TraverseDecl(context.getTranslationUnitDecl());
+void ForbidNonConstLambdaCaptureRule::reportViolation(clang::LambdaExpr* lambda,
+                                                      clang::ASTContext& context,
+                                                      DiagnosticEngine& diagnostics) {
+    report(diagnostics, context, lambda->getBeginLoc(),
+           Severity::Error, MessageId::NonConstLambdaCapture);
 }
 
 // ForbidRawPtrThreadSharingRule Implementation
 
-void ForbidRawPtrThreadSharingRule::check(clang::ASTContext& context, DiagnosticEngine& diagnostics) {
+void ForbidRawPtrThreadSharingRule::check(clang::ASTContext& context, DiagnosticEngine& diagnostics,
+                                          const CancellationToken& cancel) {
     // Basic implementation - can be enhanced / 基本实现 - 可以增强
     // Currently covered by other rules / 目前由其他规则覆盖
 }
 
 // RequireAtomicForSharedCounterRule Implementation
 
-void RequireAtomicForSharedCounterRule::check(clang::ASTContext& context, DiagnosticEngine& diagnostics) {
+void RequireAtomicForSharedCounterRule::check(clang::ASTContext& context, DiagnosticEngine& diagnostics,
+                                              const CancellationToken& cancel) {
     // Enhanced by ForbidUnsyncSharedStateRule / 由 ForbidUnsyncSharedStateRule 增强
 }
 
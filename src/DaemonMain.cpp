@@ -0,0 +1,315 @@
+﻿// Tough C Profiler - Check Daemon
+// Tough C 分析器 - 检查守护进程
+//
+// Serves tcc-check invocations over a UNIX socket from a resident process.
+// Parsed standard headers stay warm across requests as shared PCHs in the
+// daemon's cache directory.
+// 在常驻进程中经 UNIX 套接字处理 tcc-check 调用。
+// 已解析的标准头文件以共享 PCH 的形式保存在守护进程的缓存目录中，在请求之间保持常驻。
+
+#include "tcc/CheckCommand.h"
+#include "tcc/Core.h"
+#include "tcc/DaemonProtocol.h"
+#include "tcc/StringPool.h"
+
+#include <llvm/Support/raw_ostream.h>
+
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace tcc;
+
+namespace {
+
+// A client that stalls mid-message is dropped after this long
+// 在消息中途停滞的客户端在此时长后被断开
+constexpr time_t IO_TIMEOUT_SECONDS = 30;
+
+// Default --request-timeout / --request-timeout 的默认值
+constexpr unsigned DEFAULT_REQUEST_TIMEOUT_SECONDS = 300;
+
+// Cancels the request's check once it runs past its limit, so one
+// pathological TU cannot hold the daemon; 0 seconds = no limit
+// 检查运行超过时限后将其取消，避免单个病态翻译单元占住守护进程；0 秒 = 不限
+class RequestWatchdog {
+public:
+    RequestWatchdog(unsigned seconds, CancellationToken& cancel) {
+        if (seconds == 0) {
+            return;
+        }
+        thread_ = std::thread([this, seconds, &cancel]() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!wake_.wait_for(lock, std::chrono::seconds(seconds), [this]() { return done_; })) {
+                fired_ = true;
+                cancel.cancel();
+            }
+        });
+    }
+    
+    ~RequestWatchdog() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_ = true;
+        }
+        wake_.notify_one();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+    
+    // Stop watching; true if the limit was reached first / 停止监视；若先达到时限则返回 true
+    bool finish() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_ = true;
+        wake_.notify_one();
+        return fired_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool done_ = false;
+    bool fired_ = false;
+    std::thread thread_;
+};
+
+// Settings of the daemon process / 守护进程的设置
+struct DaemonSettings {
+    unsigned requestTimeout = DEFAULT_REQUEST_TIMEOUT_SECONDS;
+    std::string cacheDirectory;   // Shared PCHs and results of all requests / 所有请求的共享 PCH 和结果
+};
+
+// $XDG_CACHE_HOME/tcc-checkd, else ~/.cache/tcc-checkd, else beside the socket
+// $XDG_CACHE_HOME/tcc-checkd，否则 ~/.cache/tcc-checkd，否则在套接字旁边
+std::string getDefaultCacheDirectory(const std::string& socketPath) {
+    if (const char* cacheHome = std::getenv("XDG_CACHE_HOME")) {
+        return std::string(cacheHome) + "/tcc-checkd";
+    }
+    if (const char* home = std::getenv("HOME")) {
+        return std::string(home) + "/.cache/tcc-checkd";
+    }
+    return socketPath + ".cache";
+}
+
+// Option name of an argument without dashes or value, empty for inputs
+// 参数的选项名（不含短横线和值），输入文件为空
+std::string getOptionName(const std::string& arg) {
+    size_t start = arg.find_first_not_of('-');
+    if (start == 0 || start == std::string::npos) {
+        return std::string();
+    }
+    return arg.substr(start, arg.find('=') - start);
+}
+
+// Options that call exit() inside LLVM or never return
+// 在 LLVM 内部调用 exit() 或永不返回的选项
+bool isUnservedOption(const std::string& arg) {
+    size_t start = arg.find_first_not_of('-');
+    std::string name = start == std::string::npos ? std::string() : arg.substr(start);
+    return name.compare(0, 4, "help") == 0 || name == "print-options" ||
+           name == "print-all-options" || name == "watch";
+}
+
+bool fillAddress(const std::string& path, sockaddr_un& address) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// Bound blocking reads and writes on a client / 限制客户端上的阻塞读写时长
+void setIOTimeout(int fd) {
+    timeval timeout{};
+    timeout.tv_sec = IO_TIMEOUT_SECONDS;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+// Another daemon already answering on the path / 已有守护进程在此路径应答
+bool isDaemonRunning(const sockaddr_un& address) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+    bool running = ::connect(fd, reinterpret_cast<const sockaddr*>(&address),
+                             sizeof(address)) == 0;
+    ::close(fd);
+    return running;
+}
+
+// Run one request; invocations are serialized because options are global.
+// Requests without their own --cache-dir or --pch run with the daemon's,
+// so a PCH of their include prefix is built once and reused until a header
+// it read changes. Strings interned by the request are dropped afterwards,
+// so the pool does not grow with the daemon's uptime.
+// 运行一个请求；由于选项是全局的，调用按顺序执行。
+// 未自带 --cache-dir 或 --pch 的请求使用守护进程的设置，因此其包含前缀的 PCH 只构建一次，
+// 并复用到其读取的某个头文件改变为止。请求驻留的字符串在其结束后被丢弃，
+// 因此字符串池不会随守护进程的运行时间增长。
+CheckResponse serve(const CheckRequest& request, const DaemonSettings& settings) {
+    CheckResponse response;
+    llvm::raw_string_ostream out(response.out);
+    llvm::raw_string_ostream err(response.err);
+    
+    for (const auto& arg : request.args) {
+        if (isUnservedOption(arg)) {
+            err << "tcc-checkd: '" << arg << "' is not served by the daemon; run tcc-check directly\n";
+            err << "tcc-checkd: 守护进程不处理 '" << arg << "'；请直接运行 tcc-check\n";
+            response.exitCode = static_cast<int>(ExitCode::InvalidArguments);
+            return response;
+        }
+    }
+    
+    if (::chdir(request.workingDirectory.c_str()) != 0) {
+        err << "tcc-checkd: cannot enter " << request.workingDirectory << "\n";
+        err << "tcc-checkd: 无法进入 " << request.workingDirectory << "\n";
+        response.exitCode = static_cast<int>(ExitCode::FileNotFound);
+        return response;
+    }
+    
+    // Arguments after "--" belong to the compiler / "--" 之后的参数属于编译器
+    bool hasCacheDirectory = false;
+    bool hasPCH = false;
+    for (const auto& arg : request.args) {
+        if (arg == "--") {
+            break;
+        }
+        std::string name = getOptionName(arg);
+        hasCacheDirectory = hasCacheDirectory || name == "cache-dir";
+        hasPCH = hasPCH || name == "pch";
+    }
+    
+    std::string cacheDirectoryArg = "--cache-dir=" + settings.cacheDirectory;
+    std::vector<const char*> argv;
+    argv.push_back("tcc-check");
+    if (!hasCacheDirectory) {
+        argv.push_back(cacheDirectoryArg.c_str());
+    }
+    if (!hasPCH) {
+        argv.push_back("--pch");
+    }
+    for (const auto& arg : request.args) {
+        argv.push_back(arg.c_str());
+    }
+    argv.push_back(nullptr);
+    
+    size_t poolMark = StringPool::global().size();
+    CancellationToken cancel;
+    unsigned timeoutSeconds = settings.requestTimeout;
+    RequestWatchdog watchdog(timeoutSeconds, cancel);
+    response.exitCode = runCheckCommand(static_cast<int>(argv.size() - 1), argv.data(),
+                                        out, err, &cancel);
+    if (watchdog.finish()) {
+        err << "tcc-checkd: request cancelled after " << timeoutSeconds << " s (--request-timeout)\n";
+        err << "tcc-checkd: 请求在 " << timeoutSeconds << " 秒后被取消（--request-timeout）\n";
+        response.exitCode = static_cast<int>(ExitCode::InternalError);
+    }
+    StringPool::global().truncate(poolMark);
+    out.flush();
+    err.flush();
+    return response;
+}
+
+} // namespace
+
+// Main function / 主函数
+int main(int argc, const char** argv) {
+    std::string socketPath = getDaemonSocketPath();
+    DaemonSettings settings;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool valid = true;
+        if (arg.compare(0, 9, "--socket=") == 0) {
+            socketPath = arg.substr(9);
+        } else if (arg.compare(0, 12, "--cache-dir=") == 0) {
+            settings.cacheDirectory = arg.substr(12);
+            valid = !settings.cacheDirectory.empty();
+        } else if (arg.compare(0, 18, "--request-timeout=") == 0) {
+            char* end = nullptr;
+            settings.requestTimeout = static_cast<unsigned>(std::strtoul(arg.c_str() + 18, &end, 10));
+            valid = arg.size() > 18 && *end == '\0';
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            llvm::errs() << "Usage / 用法: tcc-checkd [--socket=<path>] [--cache-dir=<dir>] "
+                            "[--request-timeout=<seconds>]\n";
+            return static_cast<int>(ExitCode::InvalidArguments);
+        }
+    }
+    if (settings.cacheDirectory.empty()) {
+        settings.cacheDirectory = getDefaultCacheDirectory(socketPath);
+    }
+    
+    sockaddr_un address;
+    if (!fillAddress(socketPath, address)) {
+        llvm::errs() << "tcc-checkd: socket path too long / 套接字路径过长: " << socketPath << "\n";
+        return static_cast<int>(ExitCode::InvalidArguments);
+    }
+    if (isDaemonRunning(address)) {
+        llvm::errs() << "tcc-checkd: already running on / 已在运行: " << socketPath << "\n";
+        return static_cast<int>(ExitCode::InternalError);
+    }
+    
+    // Clients that go away must not kill the daemon / 客户端断开不能终止守护进程
+    std::signal(SIGPIPE, SIG_IGN);
+    
+    int listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        llvm::errs() << "tcc-checkd: socket() failed: " << std::strerror(errno) << "\n";
+        return static_cast<int>(ExitCode::InternalError);
+    }
+    
+    // Owner-only socket, replacing a stale one / 仅所有者可访问的套接字，替换陈旧的套接字
+    ::unlink(socketPath.c_str());
+    mode_t previousMask = ::umask(0077);
+    int bound = ::bind(listenFd, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+    ::umask(previousMask);
+    if (bound != 0 || ::listen(listenFd, 16) != 0) {
+        llvm::errs() << "tcc-checkd: cannot listen on " << socketPath << ": "
+                     << std::strerror(errno) << "\n";
+        ::close(listenFd);
+        return static_cast<int>(ExitCode::InternalError);
+    }
+    
+    llvm::errs() << "tcc-checkd listening on / 正在监听: " << socketPath << "\n";
+    
+    for (;;) {
+        int clientFd = ::accept(listenFd, nullptr, nullptr);
+        if (clientFd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            llvm::errs() << "tcc-checkd: accept() failed: " << std::strerror(errno) << "\n";
+            break;
+        }
+        
+        setIOTimeout(clientFd);
+        CheckRequest request;
+        if (readRequest(clientFd, request)) {
+            writeResponse(clientFd, serve(request, settings));
+        }
+        ::close(clientFd);
+    }
+    
+    ::close(listenFd);
+    ::unlink(socketPath.c_str());
+    return static_cast<int>(ExitCode::InternalError);
+}
@@ -0,0 +1,149 @@
+﻿// Tough C Profiler - Daemon Protocol Implementation
+// Tough C 分析器 - 守护进程协议实现
+
+#include "tcc/DaemonProtocol.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+
+#include <unistd.h>
+
+namespace tcc {
+
+namespace {
+
+// Frames larger than this are treated as corrupt / 超过此大小的帧视为损坏
+constexpr uint32_t MAX_FRAME_SIZE = 256u << 20;
+constexpr long MAX_ARGS = 1 << 16;
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool readAll(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t received = ::read(fd, data, size);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (received == 0) {
+            return false;
+        }
+        data += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+// Frame: 4-byte big-endian length, then bytes / 帧：4 字节大端长度，随后是内容
+bool writeFrame(int fd, const std::string& value) {
+    uint32_t size = static_cast<uint32_t>(value.size());
+    unsigned char header[4] = {
+        static_cast<unsigned char>(size >> 24),
+        static_cast<unsigned char>(size >> 16),
+        static_cast<unsigned char>(size >> 8),
+        static_cast<unsigned char>(size)
+    };
+    return writeAll(fd, reinterpret_cast<const char*>(header), sizeof(header)) &&
+           writeAll(fd, value.data(), value.size());
+}
+
+bool readFrame(int fd, std::string& value) {
+    unsigned char header[4];
+    if (!readAll(fd, reinterpret_cast<char*>(header), sizeof(header))) {
+        return false;
+    }
+    
+    uint32_t size = (uint32_t(header[0]) << 24) | (uint32_t(header[1]) << 16) |
+                    (uint32_t(header[2]) << 8) | uint32_t(header[3]);
+    if (size > MAX_FRAME_SIZE) {
+        return false;
+    }
+    
+    value.resize(size);
+    return size == 0 || readAll(fd, &value[0], size);
+}
+
+bool readNumber(int fd, long& number) {
+    std::string text;
+    if (!readFrame(fd, text) || text.empty()) {
+        return false;
+    }
+    
+    char* end = nullptr;
+    number = std::strtol(text.c_str(), &end, 10);
+    return *end == '\0';
+}
+
+} // namespace
+
+std::string getDaemonSocketPath() {
+    if (const char* path = std::getenv("TCC_CHECKD_SOCKET")) {
+        return path;
+    }
+    if (const char* runtimeDir = std::getenv("XDG_RUNTIME_DIR")) {
+        return std::string(runtimeDir) + "/tcc-checkd.sock";
+    }
+    return "/tmp/tcc-checkd-" + std::to_string(::getuid()) + ".sock";
+}
+
+bool writeRequest(int fd, const CheckRequest& request) {
+    if (!writeFrame(fd, request.workingDirectory) ||
+        !writeFrame(fd, std::to_string(request.args.size()))) {
+        return false;
+    }
+    for (const auto& arg : request.args) {
+        if (!writeFrame(fd, arg)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool readRequest(int fd, CheckRequest& request) {
+    long count = 0;
+    if (!readFrame(fd, request.workingDirectory) || !readNumber(fd, count) ||
+        count < 0 || count > MAX_ARGS) {
+        return false;
+    }
+    
+    request.args.resize(static_cast<size_t>(count));
+    for (auto& arg : request.args) {
+        if (!readFrame(fd, arg)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool writeResponse(int fd, const CheckResponse& response) {
+    return writeFrame(fd, std::to_string(response.exitCode)) &&
+           writeFrame(fd, response.out) &&
+           writeFrame(fd, response.err);
+}
+
+bool readResponse(int fd, CheckResponse& response) {
+    long exitCode = 0;
+    if (!readNumber(fd, exitCode)) {
+        return false;
+    }
+    response.exitCode = static_cast<int>(exitCode);
+    return readFrame(fd, response.out) && readFrame(fd, response.err);
+}
+
+} // namespace tcc
@@ -2,104 +2,324 @@
 // Tough C 分析器 - 诊断实现
 
 #include "tcc/Diagnostic.h"
-#include <iostream>
+#include "tcc/Baseline.h"
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
 #include <sstream>
+#include <tuple>
 
 namespace tcc {
 
+const std::string& SourceLocation::getFilename() const {
+    static const std::string unresolved;
+    return isResolved() ? StringPool::global().get(file) : unresolved;
+}
+
 Diagnostic::Diagnostic(Severity severity,
-                       std::string message,
+                       MessageId message,
                        SourceLocation location,
                        RuleCategory category,
-                       std::string ruleId)
-    : severity_(severity)
-    , message_(std::move(message))
-    , location_(std::move(location))
-    , category_(category)
-    , ruleId_(std::move(ruleId)) {}
+                       std::string_view ruleId,
+                       const std::vector<std::string_view>& arguments)
+    : location_(location)
+    , ruleId_(StringPool::global().intern(ruleId))
+    , message_(message)
+    , severity_(severity)
+    , category_(category) {
+    for (auto argument : arguments) {
+        if (argumentCount_ == MAX_ARGUMENTS) {
+            break;
+        }
+        arguments_[argumentCount_++] = StringPool::global().intern(argument);
+    }
+}
+
+Diagnostic::Diagnostic(Severity severity,
+                       MessageId message,
+                       SourceLocation location,
+                       RuleCategory category,
+                       StringId ruleId,
+                       const StringId* arguments,
+                       size_t argumentCount)
+    : location_(location)
+    , ruleId_(ruleId)
+    , message_(message)
+    , severity_(severity)
+    , category_(category) {
+    while (argumentCount_ < argumentCount && argumentCount_ < MAX_ARGUMENTS) {
+        arguments_[argumentCount_] = arguments[argumentCount_];
+        ++argumentCount_;
+    }
+}
+
+std::vector<std::string_view> Diagnostic::getArguments() const {
+    std::vector<std::string_view> arguments;
+    for (uint8_t i = 0; i < argumentCount_; ++i) {
+        arguments.push_back(StringPool::global().get(arguments_[i]));
+    }
+    return arguments;
+}
+
+std::string Diagnostic::getMessage(Locale locale) const {
+    std::string out;
+    appendMessage(out, locale);
+    return out;
+}
 
-void Diagnostic::addFixHint(std::string hint) {
-    fixHints_.push_back(std::move(hint));
+void Diagnostic::appendMessage(std::string& out, Locale locale) const {
+    std::array<std::string_view, MAX_ARGUMENTS> arguments;
+    for (uint8_t i = 0; i < argumentCount_; ++i) {
+        arguments[i] = StringPool::global().get(arguments_[i]);
+    }
+    MessageCatalog::renderTo(out, MessageCatalog::get(message_).message, locale,
+                             arguments.data(), argumentCount_);
 }
 
-void Diagnostic::addEscapePath(std::string escape) {
-    escapePaths_.push_back(std::move(escape));
+std::vector<std::string> Diagnostic::getFixHints(Locale locale) const {
+    std::vector<std::string> hints;
+    for (const auto& hint : MessageCatalog::get(message_).fixHints) {
+        hints.push_back(MessageCatalog::render(hint, locale));
+    }
+    return hints;
+}
+
+std::vector<std::string> Diagnostic::getEscapePaths(Locale locale) const {
+    std::vector<std::string> escapes;
+    for (const auto& escape : MessageCatalog::get(message_).escapePaths) {
+        escapes.push_back(MessageCatalog::render(escape, locale));
+    }
+    return escapes;
 }
 
-std::string Diagnostic::format() const {
+std::string Diagnostic::format(Locale locale) const {
     std::ostringstream oss;
     
     // Location / 位置
-    oss << location_.filename << ":" 
+    oss << location_.getFilename() << ":" 
         << location_.line << ":" 
         << location_.column << ": ";
     
     // Severity / 严重程度
     switch (severity_) {
         case Severity::Error:
-            oss << "error / 错误: ";
+            oss << MessageCatalog::render({"error", "错误"}, locale) << ": ";
             break;
         case Severity::Warning:
-            oss << "warning / 警告: ";
+            oss << MessageCatalog::render({"warning", "警告"}, locale) << ": ";
             break;
         case Severity::Note:
-            oss << "note / 提示: ";
+            oss << MessageCatalog::render({"note", "提示"}, locale) << ": ";
             break;
     }
     
     // Message and rule ID / 消息和规则ID
-    oss << message_ << " [" << ruleId_ << "]\n";
+    oss << getMessage(locale) << " [" << getRuleId() << "]\n";
     
     // Fix hints / 修复建议
-    if (!fixHints_.empty()) {
-        oss << "  Fix suggestions / 修复建议:\n";
-        for (const auto& hint : fixHints_) {
-            oss << "    → " << hint << "\n";
+    const auto& entry = MessageCatalog::get(message_);
+    if (!entry.fixHints.empty()) {
+        oss << "  " << MessageCatalog::render({"Fix suggestions", "修复建议"}, locale) << ":\n";
+        for (const auto& hint : entry.fixHints) {
+            oss << "    → " << MessageCatalog::render(hint, locale) << "\n";
         }
     }
     
     // Escape paths / 逃生路径
-    if (!escapePaths_.empty()) {
-        oss << "  Opt-out options / 退出选项:\n";
-        for (const auto& escape : escapePaths_) {
-            oss << "    ⚠ " << escape << "\n";
+    if (!entry.escapePaths.empty()) {
+        oss << "  " << MessageCatalog::render({"Opt-out options", "退出选项"}, locale) << ":\n";
+        for (const auto& escape : entry.escapePaths) {
+            oss << "    ⚠ " << MessageCatalog::render(escape, locale) << "\n";
         }
     }
     
     return oss.str();
 }
 
+void TextDiagnosticSink::handle(const Diagnostic& diag) {
+    os_ << diag.format(locale_) << "\n";
+}
+
+bool DiagnosticKey::operator==(const DiagnosticKey& other) const {
+    auto same = [](const SourceLocation& a, const SourceLocation& b) {
+        return a.file == b.file && a.line == b.line && a.column == b.column;
+    };
+    return ruleId == other.ruleId && same(expansion, other.expansion) &&
+           same(spelling, other.spelling);
+}
+
+size_t DiagnosticKeyHash::operator()(const DiagnosticKey& key) const {
+    // FNV-1a over the seven fields / 对七个字段做 FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (uint64_t field : {uint64_t(key.ruleId),
+                           uint64_t(key.expansion.file), uint64_t(key.expansion.line),
+                           uint64_t(key.expansion.column),
+                           uint64_t(key.spelling.file), uint64_t(key.spelling.line),
+                           uint64_t(key.spelling.column)}) {
+        hash = (hash ^ field) * 1099511628211ull;
+    }
+    return static_cast<size_t>(hash);
+}
+
+namespace {
+
+// Key of a stored diagnostic, whose spelling location is no longer known
+// 已存储诊断的键，其拼写位置已不可知
+DiagnosticKey storedKey(const Diagnostic& diag) {
+    return {diag.getRuleIdHandle(), diag.getLocation(), diag.getLocation()};
+}
+
+} // namespace
+
+bool DiagnosticDeduplicator::insert(const Diagnostic& diag) {
+    DiagnosticKey key = storedKey(diag);
+    std::lock_guard<std::mutex> lock(mutex_);
+    return seen_.insert(key).second;
+}
+
 void DiagnosticEngine::report(Diagnostic diag) {
+    SourceLocation spelling = diag.getLocation();
+    report(std::move(diag), spelling);
+}
+
+void DiagnosticEngine::report(Diagnostic diag, const SourceLocation& spelling) {
+    DiagnosticKey key = {diag.getRuleIdHandle(), diag.getLocation(), spelling};
+    if (!reported_.insert(key).second) {
+        return;
+    }
+    ++counts_[static_cast<size_t>(diag.getSeverity())];
+    checkCancel(diag);
     diagnostics_.push_back(std::move(diag));
 }
 
-bool DiagnosticEngine::hasErrors() const {
-    for (const auto& diag : diagnostics_) {
-        if (diag.getSeverity() == Severity::Error) {
-            return true;
+void DiagnosticEngine::append(DiagnosticEngine&& other) {
+    diagnostics_.reserve(diagnostics_.size() + other.diagnostics_.size());
+    for (auto& diag : other.diagnostics_) {
+        diagnostics_.push_back(std::move(diag));
+    }
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    reported_.insert(other.reported_.begin(), other.reported_.end());
+    if (cancelOnError_ && other.hasErrors()) {
+        for (const auto& diag : other.diagnostics_) {
+            checkCancel(diag);
         }
     }
-    return false;
+    other.clear();
 }
 
-size_t DiagnosticEngine::getErrorCount() const {
-    size_t count = 0;
+size_t DiagnosticEngine::getDiagnosticCount() const {
+    size_t total = 0;
+    for (size_t count : counts_) {
+        total += count;
+    }
+    return total;
+}
+
+void DiagnosticEngine::printAll(llvm::raw_ostream& os, Locale locale) const {
+    TextDiagnosticSink sink(os, locale);
     for (const auto& diag : diagnostics_) {
-        if (diag.getSeverity() == Severity::Error) {
-            ++count;
-        }
+        sink.handle(diag);
     }
-    return count;
 }
 
-void DiagnosticEngine::printAll(std::ostream& os) const {
+void DiagnosticEngine::flush(DiagnosticSink& sink) {
     for (const auto& diag : diagnostics_) {
-        os << diag.format() << "\n";
+        sink.handle(diag);
+    }
+    // Give the memory back, not just the elements / 归还内存，而不仅是元素
+    std::vector<Diagnostic>().swap(diagnostics_);
+    std::unordered_set<DiagnosticKey, DiagnosticKeyHash>().swap(reported_);
+}
+
+void DiagnosticEngine::removeDuplicates(DiagnosticDeduplicator& seen) {
+    removeIf([&](const Diagnostic& diag) { return !seen.insert(diag); });
+}
+
+size_t DiagnosticEngine::removeIf(const std::function<bool(const Diagnostic&)>& predicate) {
+    size_t size = diagnostics_.size();
+    size_t kept = 0;
+    for (auto& diag : diagnostics_) {
+        if (!predicate(diag)) {
+            diagnostics_[kept++] = std::move(diag);
+        } else {
+            --counts_[static_cast<size_t>(diag.getSeverity())];
+        }
+    }
+    diagnostics_.erase(diagnostics_.begin() + static_cast<std::ptrdiff_t>(kept), diagnostics_.end());
+    return size - kept;
+}
+
+void DiagnosticEngine::resolveLocations() {
+    if (!resolver_) {
+        return;
+    }
+    
+    size_t kept = 0;
+    for (auto& diag : diagnostics_) {
+        const SourceLocation raw = diag.getLocation();
+        if (raw.isResolved()) {
+            diagnostics_[kept++] = std::move(diag);
+            continue;
+        }
+        
+        // Distinct raw locations may share an expansion and spelling location;
+        // the spelling tells apart different tokens of one macro expansion
+        // 不同的原始位置可能共享同一展开位置和拼写位置；拼写位置区分同一宏展开中的不同记号
+        SourceLocation expansion = resolver_->resolve(raw.line);
+        uint32_t spellingRaw = resolver_->getSpelling(raw.line);
+        SourceLocation spelling = spellingRaw == raw.line ? expansion : resolver_->resolve(spellingRaw);
+        reported_.erase({diag.getRuleIdHandle(), raw, raw});
+        if (reported_.insert({diag.getRuleIdHandle(), expansion, spelling}).second) {
+            diag.setLocation(expansion);
+            diagnostics_[kept++] = std::move(diag);
+        } else {
+            --counts_[static_cast<size_t>(diag.getSeverity())];
+        }
+    }
+    diagnostics_.erase(diagnostics_.begin() + static_cast<std::ptrdiff_t>(kept), diagnostics_.end());
+    resolver_ = nullptr;
+}
+
+void DiagnosticEngine::sortByLocation() {
+    // Stable, and repeats of a rule at one location were already dropped
+    // 稳定排序，且同一规则在同一位置的重复报告已被丢弃
+    std::stable_sort(diagnostics_.begin(), diagnostics_.end(),
+                     [](const Diagnostic& a, const Diagnostic& b) {
+        const SourceLocation& left = a.getLocation();
+        const SourceLocation& right = b.getLocation();
+        if (left.file != right.file) {
+            return left.getFilename() < right.getFilename();
+        }
+        return std::tie(left.line, left.column, a.getRuleId()) <
+               std::tie(right.line, right.column, b.getRuleId());
+    });
+}
+
+void DiagnosticEngine::checkCancel(const Diagnostic& diag) const {
+    if (!cancelOnError_ || diag.getSeverity() != Severity::Error) {
+        return;
+    }
+    
+    // The baseline fingerprints the file, the arguments and the text of the
+    // line and its two neighbours, so the location must be resolved first
+    // 基线对文件、参数以及该行及其上下两行的文本计算指纹，因此须先解析位置
+    if (baseline_) {
+        Diagnostic resolved = diag;
+        if (!resolved.getLocation().isResolved() && resolver_) {
+            resolved.setLocation(resolver_->resolve(resolved.getLocation().line));
+        }
+        if (baseline_->contains(resolved)) {
+            return;
+        }
     }
+    cancelOnError_->cancel();
 }
 
 void DiagnosticEngine::clear() {
     diagnostics_.clear();
+    reported_.clear();
+    counts_ = {};
 }
 
 } // namespace tcc
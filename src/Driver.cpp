@@ -0,0 +1,385 @@
+﻿// Tough C Profiler - Analysis Driver Implementation
+// Tough C 分析器 - 分析驱动实现
+
+#include "tcc/Driver.h"
+
+#include <clang/Basic/DiagnosticIDs.h>
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/FrontendActions.h>
+#include <clang/Frontend/TextDiagnosticPrinter.h>
+#include <clang/Frontend/Utils.h>
+#include <clang/Tooling/ArgumentsAdjusters.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace tcc {
+
+namespace {
+
+// Inputs and outputs of one frontend run / 一次前端运行的输入和输出
+struct FrontendRun {
+    RuleEngine& engine;
+    TUResult& result;
+    CategoryMask categories;
+    bool recordDependencies;
+    const CancellationToken& cancel;
+    double analysisWallSeconds = 0;   // Time in RuleEngine::analyze / 在 RuleEngine::analyze 中的时间
+    double analysisCpuSeconds = 0;
+};
+
+// Custom AST Consumer / 自定义 AST 消费者
+class TCCASTConsumer : public clang::ASTConsumer {
+public:
+    explicit TCCASTConsumer(FrontendRun& run) : run_(run) {}
+    
+    // Returning false aborts parsing, so a cancelled TU stops mid-file
+    // 返回 false 会中止解析，被取消的翻译单元在文件中途停止
+    bool HandleTopLevelDecl(clang::DeclGroupRef) override {
+        return !run_.cancel.isCancelled();
+    }
+    
+    void HandleTranslationUnit(clang::ASTContext& context) override {
+        Stopwatch stopwatch;
+        run_.engine.analyze(context, run_.result.diagnostics, run_.categories, run_.cancel);
+        run_.analysisWallSeconds += stopwatch.wallSeconds();
+        run_.analysisCpuSeconds += stopwatch.cpuSeconds();
+    }
+
+private:
+    FrontendRun& run_;
+};
+
+// Custom Frontend Action / 自定义前端动作
+class TCCFrontendAction : public clang::ASTFrontendAction {
+public:
+    explicit TCCFrontendAction(FrontendRun& run) : run_(run) {}
+    
+    std::unique_ptr<clang::ASTConsumer> CreateASTConsumer(
+        clang::CompilerInstance&, llvm::StringRef) override {
+        return std::make_unique<TCCASTConsumer>(run_);
+    }
+
+protected:
+    // Collectors must be attached before the preprocessor is created
+    // 收集器必须在预处理器创建之前附加
+    bool BeginInvocation(clang::CompilerInstance& ci) override {
+        if (run_.recordDependencies) {
+            dependencies_ = std::make_shared<clang::DependencyCollector>();
+            ci.addDependencyCollector(dependencies_);
+        }
+        return true;
+    }
+    
+    void EndSourceFileAction() override {
+        if (dependencies_) {
+            auto files = dependencies_->getDependencies();
+            run_.result.dependencies.assign(files.begin(), files.end());
+        }
+    }
+
+private:
+    FrontendRun& run_;
+    std::shared_ptr<clang::DependencyCollector> dependencies_;
+};
+
+// Prints compiler diagnostics and notes errors from loading a PCH
+// 打印编译器诊断，并记录加载 PCH 时的错误
+class CompilerDiagnosticPrinter : public clang::TextDiagnosticPrinter {
+public:
+    using clang::TextDiagnosticPrinter::TextDiagnosticPrinter;
+    
+    void HandleDiagnostic(clang::DiagnosticsEngine::Level level,
+                          const clang::Diagnostic& info) override {
+        // The AST reader reports through the serialization diagnostics
+        // AST 读取器通过序列化诊断报告
+        unsigned id = info.getID();
+        if (level >= clang::DiagnosticsEngine::Error &&
+            id >= clang::diag::DIAG_START_SERIALIZATION && id < clang::diag::DIAG_START_LEX) {
+            pchFailed_ = true;
+        }
+        clang::TextDiagnosticPrinter::HandleDiagnostic(level, info);
+    }
+    
+    bool hasPCHFailure() const { return pchFailed_; }
+
+private:
+    bool pchFailed_ = false;
+};
+
+// Frontend Action Factory / 前端动作工厂
+class TCCActionFactory : public clang::tooling::FrontendActionFactory {
+public:
+    explicit TCCActionFactory(FrontendRun& run) : run_(run) {}
+    
+    std::unique_ptr<clang::FrontendAction> create() override {
+        return std::make_unique<TCCFrontendAction>(run_);
+    }
+
+private:
+    FrontendRun& run_;
+};
+
+} // namespace
+
+Driver::Driver(const clang::tooling::CompilationDatabase& compilations,
+               DriverOptions options,
+               llvm::raw_ostream& log)
+    : compilations_(compilations)
+    , options_(options)
+    , log_(log) {
+    if (!options_.cacheDirectory.empty()) {
+        cache_ = std::make_unique<ResultCache>(options_.cacheDirectory,
+                                               options_.cacheMaxBytes);
+        if (options_.sharedPCH) {
+            pch_ = std::make_unique<SharedPCH>(compilations_, options_.cacheDirectory);
+        }
+    }
+}
+
+std::unique_ptr<RuleEngine> Driver::createEngine(const DriverOptions& options) {
+    auto engine = std::make_unique<RuleEngine>();
+    engine->setApiCatalog(options.apiCatalog);
+    engine->setTraversalThreads(options.tuThreads);
+    engine->setGateMode(options.gate);
+    engine->initializeDefaultRules();
+    for (const RulePlugin* plugin : options.plugins) {
+        engine->addPluginRules(*plugin);
+    }
+    engine->enableCategory(RuleCategory::Ownership, options.ownershipChecks);
+    engine->enableCategory(RuleCategory::Lifetime, options.lifetimeChecks);
+    engine->enableCategory(RuleCategory::Concurrency, options.concurrencyChecks);
+    return engine;
+}
+
+std::vector<TUResult> Driver::run(const std::vector<std::string>& files,
+                                  const ResultCallback& onResult) {
+    std::vector<TUResult> results(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        results[i].file = files[i];
+    }
+    
+    unsigned workerCount = getWorkerCount(files.size());
+    
+    // Drop files that do not opt in before any frontend work
+    // 在任何前端工作之前丢弃未启用 TCC 的文件
+    std::atomic<size_t> nextGate{0};
+    runWorkers(workerCount, [&]() {
+        for (size_t i = nextGate++; i < files.size(); i = nextGate++) {
+            gateFile(results[i]);
+        }
+    });
+    
+    // Precompile the shared include prefix of the TCC files
+    // 预编译 TCC 文件共享的包含前缀
+    if (pch_) {
+        std::vector<std::string> tccFiles;
+        for (const auto& result : results) {
+            if (result.config) {
+                tccFiles.push_back(result.file);
+            }
+        }
+        Stopwatch stopwatch;
+        pch_->prepare(tccFiles, options_.verbose, log_);
+        recordPhase("shared PCH", stopwatch);
+    }
+    
+    // Each worker owns its engine and writes only to its claimed slots.
+    // A location reported by several TUs, such as a header, is kept for
+    // the first of them in input order, so a finished result waits until
+    // every earlier one is done.
+    // 每个工作线程拥有自己的引擎，只写入自己领取的结果槽。
+    // 被多个翻译单元报告的位置（如头文件）按输入顺序保留在第一个翻译单元中，
+    // 因此已完成的结果要等待之前的所有结果完成。
+    std::atomic<size_t> nextFile{0};
+    std::vector<char> finished(files.size(), 0);
+    size_t nextRelease = 0;
+    DiagnosticDeduplicator seen;
+    CancellationToken ownCancel;
+    CancellationToken& cancel = options_.cancel ? *options_.cancel : ownCancel;
+    auto release = [&](size_t index) {
+        std::lock_guard<std::mutex> lock(resultMutex_);
+        finished[index] = 1;
+        for (; nextRelease < files.size() && finished[nextRelease]; ++nextRelease) {
+            TUResult& result = results[nextRelease];
+            result.diagnostics.removeDuplicates(seen);
+            if (options_.baseline) {
+                result.baselined = options_.baseline->filter(result.diagnostics);
+            }
+            if (onResult) {
+                onResult(result);
+            }
+        }
+    };
+    runWorkers(workerCount, [&]() {
+        auto engine = createEngine(options_);
+        engine->enableProfiling(options_.timeReport != nullptr);
+        for (size_t i = nextFile++; i < files.size(); i = nextFile++) {
+            // No new TU is parsed after the first error / 第一个错误之后不再解析新的翻译单元
+            if (cancel.isCancelled()) {
+                results[i].cancelled = results[i].config.has_value();
+            } else {
+                checkFile(*engine, results[i], cancel);
+            }
+            release(i);
+        }
+        if (options_.timeReport) {
+            engine->reportProfile(*options_.timeReport);
+        }
+    });
+    
+    if (cache_) {
+        cache_->evict();
+    }
+    
+    return results;
+}
+
+void Driver::runWorkers(unsigned workerCount, const std::function<void()>& worker) {
+    if (workerCount <= 1) {
+        worker();
+        return;
+    }
+    
+    std::vector<std::thread> threads;
+    threads.reserve(workerCount);
+    for (unsigned i = 0; i < workerCount; ++i) {
+        threads.emplace_back(worker);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void Driver::gateFile(TUResult& result) {
+    Stopwatch stopwatch;
+    result.config = FileDetector::parseConfig(result.file);
+    recordPhase("file detection", stopwatch);
+    
+    if (!result.config && options_.verbose) {
+        std::lock_guard<std::mutex> lock(outputMutex_);
+        log_ << "Skipping non-TCC file: " << result.file << "\n";
+        log_ << "跳过非 TCC 文件: " << result.file << "\n";
+    }
+}
+
+void Driver::checkFile(RuleEngine& engine, TUResult& result, CancellationToken& cancel) {
+    if (!result.config) {
+        return;
+    }
+    
+    if (options_.failFast) {
+        result.diagnostics.cancelOnError(&cancel, options_.baseline);
+    }
+    
+    // Nothing left to check once the file opts out of every category
+    // 文件退出所有类别后无需检查
+    CategoryMask categories = engine.getCategoryMask(*result.config);
+    if (categories == 0) {
+        return;
+    }
+    
+    if (options_.verbose) {
+        std::lock_guard<std::mutex> lock(outputMutex_);
+        log_ << "Processing file: " << result.file << "\n";
+        log_ << "处理文件: " << result.file << "\n";
+    }
+    
+    // Replay cached diagnostics without building an AST / 回放缓存的诊断，无需构建 AST
+    std::string cacheKey;
+    if (cache_) {
+        Stopwatch stopwatch;
+        cacheKey = ResultCache::computeKey(
+            compilations_, result.file, engine.getRuleSetSignature(),
+            options_.recordDependencies ? &result.dependencies : nullptr);
+        result.cacheHit = !cacheKey.empty() && cache_->lookup(cacheKey, result.diagnostics);
+        recordPhase("result cache", stopwatch);
+        
+        if (result.cacheHit) {
+            if (options_.verbose) {
+                std::lock_guard<std::mutex> lock(outputMutex_);
+                log_ << "Cache hit: " << result.file << "\n";
+                log_ << "缓存命中: " << result.file << "\n";
+            }
+            return;
+        }
+    }
+    
+    std::string pch = pch_ ? pch_->getPCHFor(result.file) : std::string();
+    bool pchFailed = false;
+    result.toolStatus = runFrontend(engine, result, categories, pch, cancel, &pchFailed);
+    
+    // A PCH the AST reader rejects fails the whole TU; retry without it.
+    // Errors in the file itself are reported from the first run.
+    // 被 AST 读取器拒绝的 PCH 会使整个翻译单元失败；不使用它重试。文件本身的错误按第一次运行报告。
+    if (pchFailed && !cancel.isCancelled()) {
+        result.diagnostics.clear();
+        result.compilerOutput.clear();
+        result.toolStatus = runFrontend(engine, result, categories, std::string(), cancel);
+    }
+    
+    // A cancelled run may have stopped anywhere, so its result is partial
+    // 被取消的运行可能在任意位置停止，因此其结果不完整
+    result.cancelled = cancel.isCancelled();
+    
+    // Only cache TUs that compiled cleanly and ran to the end
+    // 仅缓存编译成功且完整运行的翻译单元
+    if (!cacheKey.empty() && result.toolStatus == 0 && !result.cancelled) {
+        cache_->store(cacheKey, result.diagnostics);
+    }
+}
+
+int Driver::runFrontend(RuleEngine& engine, TUResult& result, CategoryMask categories,
+                        const std::string& pch, const CancellationToken& cancel,
+                        bool* pchFailed) {
+    // Capture compiler errors per TU so parallel runs and the daemon
+    // print them intact / 按翻译单元捕获编译错误，并行运行和守护进程可完整输出
+    llvm::raw_string_ostream compilerStream(result.compilerOutput);
+    CompilerDiagnosticPrinter compilerDiagnostics(compilerStream,
+                                                  new clang::DiagnosticOptions());
+    
+    clang::tooling::ClangTool tool(compilations_, {result.file});
+    tool.setDiagnosticConsumer(&compilerDiagnostics);
+    if (!pch.empty()) {
+        tool.appendArgumentsAdjuster(clang::tooling::getInsertArgumentAdjuster(
+            {"-include-pch", pch}, clang::tooling::ArgumentInsertPosition::BEGIN));
+    }
+    
+    FrontendRun run{engine, result, categories, options_.recordDependencies, cancel};
+    TCCActionFactory actionFactory(run);
+    Stopwatch stopwatch;
+    int status = tool.run(&actionFactory);
+    compilerStream.flush();
+    if (pchFailed) {
+        *pchFailed = compilerDiagnostics.hasPCHFailure();
+    }
+    
+    // Everything outside RuleEngine::analyze is driver, parse and Sema
+    // RuleEngine::analyze 之外的时间都属于驱动、解析和语义分析
+    if (options_.timeReport) {
+        options_.timeReport->addPhase("parse/Sema",
+                                      stopwatch.wallSeconds() - run.analysisWallSeconds,
+                                      stopwatch.cpuSeconds() - run.analysisCpuSeconds);
+        options_.timeReport->addPhase("rules", run.analysisWallSeconds, run.analysisCpuSeconds);
+    }
+    return status;
+}
+
+void Driver::recordPhase(const char* phase, const Stopwatch& stopwatch) {
+    if (options_.timeReport) {
+        options_.timeReport->addPhase(phase, stopwatch);
+    }
+}
+
+unsigned Driver::getWorkerCount(size_t fileCount) const {
+    unsigned jobs = options_.jobs;
+    if (jobs == 0) {
+        jobs = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return static_cast<unsigned>(std::min<size_t>(jobs, fileCount));
+}
+
+} // namespace tcc
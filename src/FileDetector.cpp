@@ -9,7 +9,7 @@
 namespace tcc {
 
 bool FileDetector::shouldAnalyze(const std::string& filename) {
-    return hasTCCExtension(filename) || hasTCCAnnotation(filename);
+    return parseConfig(filename).has_value();
 }
 
 bool FileDetector::hasTCCExtension(const std::string& filename) {
@@ -22,40 +22,40 @@ bool FileDetector::hasTCCExtension(const std::string& filename) {
     return false;
 }
 
-bool FileDetector::hasTCCAnnotation(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        return false;
-    }
-    
-    // Read first 100 lines to look for @tcc / 读取前100行查找 @tcc
+bool FileDetector::hasTCCAnnotation(const std::string& prefix) {
+    // Look for // @tcc or /* @tcc */
+    return prefix.find("@tcc") != std::string::npos;
+}
+
+std::string FileDetector::readLines(std::istream& input, int count) {
+    std::string content;
     std::string line;
-    int lineCount = 0;
-    while (std::getline(file, line) && lineCount < 100) {
-        // Look for // @tcc or /* @tcc */
-        if (line.find("@tcc") != std::string::npos) {
-            return true;
+    for (int lineCount = 0; lineCount < count && std::getline(input, line); ++lineCount) {
+        content += line;
+        if (!input.eof()) {
+            content += '\n';
         }
-        ++lineCount;
     }
-    
-    return false;
+    return content;
 }
 
 std::optional<TCCConfig> FileDetector::parseConfig(const std::string& filename) {
-    if (!shouldAnalyze(filename)) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
         return std::nullopt;
     }
     
-    std::ifstream file(filename);
-    if (!file.is_open()) {
+    // Decide on the marker lines alone / 只根据标记所在的行做决定
+    std::string content = readLines(file, ANNOTATION_LINES);
+    if (!hasTCCExtension(filename) && !hasTCCAnnotation(content)) {
         return std::nullopt;
     }
     
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string content = buffer.str();
-    
+    // Options may appear anywhere; continue on the same stream
+    // 选项可能出现在任何位置；在同一个流上继续读取
+    std::stringstream rest;
+    rest << file.rdbuf();
+    content += rest.str();
     return parseAnnotation(content);
 }
 
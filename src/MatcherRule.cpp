@@ -0,0 +1,49 @@
+﻿// Tough C Profiler - Matcher Rules Implementation
+// Tough C 分析器 - 匹配器规则实现
+
+#include "tcc/MatcherRule.h"
+#include "tcc/TimeReport.h"
+
+namespace tcc {
+
+RuleMatchFinder::MatchCallback* RuleMatchFinder::addRule(Rule* rule, MatchHandler handler,
+                                                          RuleStats* stats) {
+    callbacks_.push_back(std::make_unique<Callback>(*this, rule, handler, stats));
+    return callbacks_.back().get();
+}
+
+void RuleMatchFinder::matchAST(const NodeHookContext& hook, const CancellationToken& cancel) {
+    // matchAST walks the traversal scope with one MatchASTVisitor; match()
+    // would build a new visitor and memo cache for every node
+    // matchAST 用一个 MatchASTVisitor 遍历遍历范围；match() 会为每个节点新建访问者和记忆化缓存
+    hook_ = &hook;
+    cancel_ = &cancel;
+    finder_.matchAST(hook.context);
+    hook_ = nullptr;
+    cancel_ = nullptr;
+}
+
+void RuleMatchFinder::Callback::run(const MatchResult& result) {
+    // The pass cannot be interrupted, so later matches are only skipped
+    // 扫描无法中断，因此之后的匹配只是被跳过
+    if (owner_.cancel_->isCancelled()) {
+        return;
+    }
+    
+    const NodeHookContext& hook = *owner_.hook_;
+    if (!stats_) {
+        handler_(rule_, result, hook);
+        return;
+    }
+    
+    DiagnosticEngine& diagnostics = hook.diagnostics;
+    size_t before = diagnostics.getDiagnostics().size();
+    Stopwatch stopwatch;
+    handler_(rule_, result, hook);
+    stats_->wallSeconds += stopwatch.wallSeconds();
+    stats_->cpuSeconds += stopwatch.cpuSeconds();
+    stats_->nodes += 1;
+    stats_->diagnostics += diagnostics.getDiagnostics().size() - before;
+}
+
+} // namespace tcc
@@ -0,0 +1,138 @@
+﻿// Tough C Profiler - Shard Merge Tool
+// Tough C 分析器 - 分片合并工具
+//
+// Merges binary shard results of a split CI run into one report
+// 将拆分 CI 运行的二进制分片结果合并为一份报告
+
+#include "tcc/Core.h"
+#include "tcc/OutputFormat.h"
+#include "tcc/ShardFile.h"
+
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+using namespace tcc;
+using namespace llvm;
+
+namespace {
+
+// Command line options / 命令行选项
+cl::OptionCategory MergeCategory("tcc-merge Options / tcc-merge 选项");
+
+cl::list<std::string> InputShards(
+    cl::Positional,
+    cl::desc("<shard files>"),
+    cl::OneOrMore,
+    cl::cat(MergeCategory)
+);
+
+cl::opt<OutputFormat> Format(
+    "format",
+    cl::desc("Output format / 输出格式"),
+    cl::values(
+        clEnumValN(OutputFormat::Text, "text", "Human-readable (default) / 人类可读（默认）"),
+        clEnumValN(OutputFormat::SARIF, "sarif", "SARIF 2.1.0"),
+        clEnumValN(OutputFormat::JSONLines, "jsonl", "One JSON object per line / 每行一个 JSON 对象")),
+    cl::init(OutputFormat::Text),
+    cl::cat(MergeCategory)
+);
+
+cl::opt<Locale> OutputLocale(
+    "locale",
+    cl::desc("Language of diagnostic text / 诊断文本的语言"),
+    cl::values(
+        clEnumValN(Locale::Bilingual, "both", "English and Chinese (default) / 英文和中文（默认）"),
+        clEnumValN(Locale::English, "en", "English only / 仅英文"),
+        clEnumValN(Locale::Chinese, "zh", "Chinese only / 仅中文")),
+    cl::init(Locale::Bilingual),
+    cl::cat(MergeCategory)
+);
+
+cl::opt<std::string> OutputFile(
+    "o",
+    cl::desc("Write the report here instead of stdout / 将报告写到此处而非标准输出"),
+    cl::value_desc("file"),
+    cl::init("-"),
+    cl::cat(MergeCategory)
+);
+
+cl::opt<std::string> ShardOutput(
+    "shard-output",
+    cl::desc("Also write the merged result as a shard, for merging in stages / "
+             "同时将合并结果写为分片，便于分级合并"),
+    cl::value_desc("file"),
+    cl::cat(MergeCategory)
+);
+
+// Counts errors on the way through / 在转发过程中统计错误
+class ErrorCounter : public DiagnosticSink {
+public:
+    void handle(const Diagnostic& diag) override {
+        if (diag.getSeverity() == Severity::Error) {
+            ++errors_;
+        }
+    }
+    
+    size_t getErrorCount() const { return errors_; }
+
+private:
+    size_t errors_ = 0;
+};
+
+} // namespace
+
+// Main function / 主函数
+int main(int argc, const char** argv) {
+    cl::HideUnrelatedOptions(MergeCategory);
+    cl::ParseCommandLineOptions(argc, argv,
+        "tcc-merge - merge tcc-check shard results\n"
+        "tcc-merge - 合并 tcc-check 分片结果\n");
+    
+    std::vector<ShardReader> shards(InputShards.size());
+    for (size_t i = 0; i < shards.size(); ++i) {
+        std::string error;
+        if (!shards[i].open(InputShards[i], error)) {
+            errs() << "tcc-merge: " << error << "\n";
+            return static_cast<int>(ExitCode::FileNotFound);
+        }
+    }
+    
+    std::error_code ec;
+    raw_fd_ostream out(OutputFile, ec);
+    if (ec) {
+        errs() << "tcc-merge: cannot write / 无法写入 " << OutputFile << ": " << ec.message() << "\n";
+        return static_cast<int>(ExitCode::InvalidArguments);
+    }
+    
+    auto report = createOutputSink(Format, out, OutputLocale);
+    ErrorCounter counter;
+    std::vector<DiagnosticSink*> sinks = {report.get(), &counter};
+    std::unique_ptr<ShardWriter> shardWriter;
+    if (!ShardOutput.empty()) {
+        shardWriter = std::make_unique<ShardWriter>(ShardOutput);
+        sinks.push_back(shardWriter.get());
+    }
+    
+    TeeDiagnosticSink sink(std::move(sinks));
+    size_t written = mergeShards(shards, sink);
+    out.flush();
+    
+    if (shardWriter && !shardWriter->getError().empty()) {
+        errs() << "tcc-merge: " << shardWriter->getError() << "\n";
+        return static_cast<int>(ExitCode::InternalError);
+    }
+    
+    errs() << "Merged " << written << " diagnostics from " << shards.size() << " shards\n";
+    errs() << "从 " << shards.size() << " 个分片合并了 " << written << " 条诊断\n";
+    if (counter.getErrorCount() > 0) {
+        errs() << "Errors: " << counter.getErrorCount() << "\n";
+        errs() << "错误数: " << counter.getErrorCount() << "\n";
+        return static_cast<int>(ExitCode::RuleViolation);
+    }
+    return static_cast<int>(ExitCode::Success);
+}
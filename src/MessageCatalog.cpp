@@ -0,0 +1,169 @@
+﻿// Tough C Profiler - Message Catalog Implementation
+// Tough C 分析器 - 消息目录实现
+
+#include "tcc/MessageCatalog.h"
+
+namespace tcc {
+
+namespace {
+
+// Escape paths shared by most rules / 大多数规则共用的退出选项
+const LocalizedText REMOVE_ANNOTATION = {"Remove @tcc annotation", "移除 @tcc 注解"};
+const LocalizedText REMOVE_ANNOTATION_CXX = {"Remove @tcc annotation to use raw C++",
+                                             "移除 @tcc 注解以使用原始 C++"};
+const LocalizedText MOVE_TO_NON_TCC = {"Move this code to a non-TCC file",
+                                       "将此代码移至非 TCC 文件"};
+
+// Indexed by MessageId / 按 MessageId 索引
+const std::vector<MessageEntry>& entries() {
+    static const std::vector<MessageEntry> table = {
+        // ForbidNew
+        {{"Use of 'new' operator is forbidden in TCC code",
+          "TCC 代码中禁止使用 'new' 操作符"},
+         {{"Use std::make_unique<T>() for single objects",
+           "对单个对象使用 std::make_unique<T>()"},
+          {"Use std::make_shared<T>() for shared ownership",
+           "对共享所有权使用 std::make_shared<T>()"},
+          {"Use std::vector<T> or other containers for arrays",
+           "对数组使用 std::vector<T> 或其他容器"}},
+         {REMOVE_ANNOTATION_CXX, MOVE_TO_NON_TCC}},
+        
+        // ForbidDelete
+        {{"Use of 'delete' operator is forbidden in TCC code",
+          "TCC 代码中禁止使用 'delete' 操作符"},
+         {{"Use smart pointers (std::unique_ptr, std::shared_ptr) with automatic cleanup",
+           "使用智能指针（std::unique_ptr、std::shared_ptr）自动清理"},
+          {"Use RAII pattern for resource management", "使用 RAII 模式管理资源"}},
+         {REMOVE_ANNOTATION_CXX, MOVE_TO_NON_TCC}},
+        
+        // ForbidAllocation
+        {{"Use of '%0' is forbidden in TCC code", "TCC 代码中禁止使用 '%0'"},
+         {{"Use std::vector<T> for arrays", "对数组使用 std::vector<T>"},
+          {"Use std::make_unique<T>() for single objects",
+           "对单个对象使用 std::make_unique<T>()"},
+          {"Use standard containers (std::string, std::array, etc.)",
+           "使用标准容器（std::string、std::array 等）"}},
+         {{"Remove @tcc annotation to use raw C", "移除 @tcc 注解以使用原始 C"},
+          MOVE_TO_NON_TCC}},
+        
+        // ForbidDeallocation
+        {{"Use of '%0' is forbidden in TCC code", "TCC 代码中禁止使用 '%0'"},
+         {{"Use smart pointers with automatic cleanup", "使用智能指针自动清理"},
+          {"Use RAII pattern", "使用 RAII 模式"}},
+         {{"Remove @tcc annotation to use raw C", "移除 @tcc 注解以使用原始 C"},
+          MOVE_TO_NON_TCC}},
+        
+        // RawOwningReturn
+        {{"Function '%0' returns raw pointer with ownership semantics",
+          "函数 '%0' 返回具有所有权语义的原始指针"},
+         {{"Return std::unique_ptr<T> instead of T*", "返回 std::unique_ptr<T> 而不是 T*"},
+          {"Return std::shared_ptr<T> for shared ownership",
+           "对共享所有权返回 std::shared_ptr<T>"},
+          {"Return by value if the object is small", "如果对象较小则按值返回"}},
+         {{"Use non-owning raw pointer (document ownership)",
+           "使用非所有权原始指针（记录所有权）"},
+          REMOVE_ANNOTATION}},
+        
+        // DanglingReference
+        {{"Returning reference to local variable (dangling reference)",
+          "返回局部变量的引用（悬空引用）"},
+         {{"Return by value instead of by reference", "按值返回而不是按引用返回"},
+          {"Return reference to member variable or parameter", "返回成员变量或参数的引用"},
+          {"Use std::unique_ptr or std::shared_ptr for heap allocation",
+           "对堆分配使用 std::unique_ptr 或 std::shared_ptr"}},
+         {REMOVE_ANNOTATION}},
+        
+        // DanglingPointer
+        {{"Returning pointer to local variable (dangling pointer)",
+          "返回局部变量的指针（悬空指针）"},
+         {{"Return std::unique_ptr<T> instead", "返回 std::unique_ptr<T>"},
+          {"Return by value", "按值返回"},
+          {"Allocate on heap with smart pointer", "使用智能指针在堆上分配"}},
+         {REMOVE_ANNOTATION}},
+        
+        // RawPointerContainer
+        {{"Container storing raw pointers (lifetime unclear)",
+          "容器存储原始指针（生命周期不明确）"},
+         {{"Use std::vector<std::unique_ptr<T>>", "使用 std::vector<std::unique_ptr<T>>"},
+          {"Use std::vector<std::shared_ptr<T>>", "使用 std::vector<std::shared_ptr<T>>"},
+          {"Store values instead of pointers", "存储值而不是指针"}},
+         {REMOVE_ANNOTATION}},
+        
+        // UntrackedReferenceMember
+        {{"Reference member without clear lifetime tracking",
+          "没有明确生命周期跟踪的引用成员"},
+         {{"Use std::reference_wrapper<T> for clearer semantics",
+           "使用 std::reference_wrapper<T> 以获得更清晰的语义"},
+          {"Store by value if possible", "如果可能按值存储"},
+          {"Use pointer with ownership documentation", "使用指针并记录所有权"}},
+         {{"Document lifetime dependency clearly", "清楚地记录生命周期依赖关系"}}},
+        
+        // UnsyncSharedState
+        {{"Global/static mutable state without synchronization",
+          "全局/静态可变状态没有同步"},
+         {{"Use std::atomic<T> for simple types", "对简单类型使用 std::atomic<T>"},
+          {"Use std::mutex for complex state", "对复杂状态使用 std::mutex"},
+          {"Use thread_local for thread-specific state", "对线程特定状态使用 thread_local"}},
+         {{"Document thread-safety explicitly", "明确记录线程安全性"}}},
+        
+        // NonConstLambdaCapture
+        {{"Lambda captures non-const reference (potential data race)",
+          "Lambda 捕获非 const 引用（潜在数据竞争）"},
+         {{"Capture by value instead: [=]", "改为按值捕获：[=]"},
+          {"Capture as const reference if read-only", "如果只读则捕获为 const 引用"},
+          {"Use std::atomic or mutex for shared state", "对共享状态使用 std::atomic 或 mutex"}},
+         {REMOVE_ANNOTATION}},
+        
+        // PluginRule: the rule supplies both texts / 规则提供两种语言的文本
+        {{"%0", "%1"}, {}, {}},
+    };
+    return table;
+}
+
+// Append `text` with "%N" replaced by arguments[N] / 追加 `text`，将 "%N" 替换为 arguments[N]
+void substitute(std::string& out, const char* text,
+                const std::string_view* arguments, size_t argumentCount) {
+    for (const char* p = text; *p; ++p) {
+        if (p[0] == '%' && p[1] >= '0' && p[1] <= '9') {
+            size_t index = static_cast<size_t>(p[1] - '0');
+            if (index < argumentCount) {
+                out.append(arguments[index]);
+            }
+            ++p;
+            continue;
+        }
+        out.push_back(*p);
+    }
+}
+
+} // namespace
+
+const MessageEntry& MessageCatalog::get(MessageId id) {
+    return entries()[static_cast<size_t>(id)];
+}
+
+std::string MessageCatalog::render(const LocalizedText& text, Locale locale,
+                                   const std::vector<std::string_view>& arguments) {
+    std::string out;
+    renderTo(out, text, locale, arguments.data(), arguments.size());
+    return out;
+}
+
+void MessageCatalog::renderTo(std::string& out, const LocalizedText& text, Locale locale,
+                              const std::string_view* arguments, size_t argumentCount) {
+    switch (locale) {
+        case Locale::English:
+            substitute(out, text.english, arguments, argumentCount);
+            break;
+        case Locale::Chinese:
+            substitute(out, text.chinese, arguments, argumentCount);
+            break;
+        case Locale::Bilingual:
+            substitute(out, text.english, arguments, argumentCount);
+            out += " / ";
+            substitute(out, text.chinese, arguments, argumentCount);
+            break;
+    }
+}
+
+} // namespace tcc
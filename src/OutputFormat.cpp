@@ -0,0 +1,307 @@
+﻿// Tough C Profiler - Machine-Readable Output Implementation
+// Tough C 分析器 - 机器可读输出实现
+
+#include "tcc/OutputFormat.h"
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <charconv>
+
+namespace tcc {
+
+namespace {
+
+constexpr const char* SARIF_SCHEMA = "https://json.schemastore.org/sarif-2.1.0.json";
+
+// SARIF level names double as the JSON Lines severity / SARIF 级别名同时用作 JSON Lines 的严重程度
+const char* getSeverityName(Severity severity) {
+    switch (severity) {
+        case Severity::Error:
+            return "error";
+        case Severity::Warning:
+            return "warning";
+        case Severity::Note:
+            return "note";
+    }
+    return "none";
+}
+
+const char* getCategoryName(RuleCategory category) {
+    switch (category) {
+        case RuleCategory::Ownership:
+            return "ownership";
+        case RuleCategory::Lifetime:
+            return "lifetime";
+        case RuleCategory::Concurrency:
+            return "concurrency";
+        case RuleCategory::TypeSafety:
+            return "type-safety";
+    }
+    return "unknown";
+}
+
+// Absolute file:// URI of `path` (RFC 8089), percent-encoding every byte
+// outside the unreserved set, '/' and ':'
+// `path` 的绝对 file:// URI（RFC 8089），对非保留字符集、'/' 和 ':' 之外的每个字节做百分号编码
+std::string toFileURI(llvm::StringRef path) {
+    llvm::SmallString<256> absolute(path);
+    llvm::sys::fs::make_absolute(absolute);
+    llvm::sys::path::remove_dots(absolute, /*remove_dot_dot=*/true);
+    std::string slashed = llvm::sys::path::convert_to_slash(absolute);
+    
+    // Windows paths start with a drive letter / Windows 路径以盘符开头
+    std::string uri = slashed.empty() || slashed.front() != '/' ? "file:///" : "file://";
+    static constexpr char HEX[] = "0123456789ABCDEF";
+    for (unsigned char c : slashed) {
+        if (llvm::isAlnum(c) || c == '-' || c == '.' || c == '_' || c == '~' ||
+            c == '/' || c == ':') {
+            uri += static_cast<char>(c);
+        } else {
+            uri += '%';
+            uri += HEX[c >> 4];
+            uri += HEX[c & 0xF];
+        }
+    }
+    return uri;
+}
+
+// Fields shared by both formats / 两种格式共有的字段
+void writeHints(JSONBuffer& json, const Diagnostic& diag, Locale locale) {
+    const auto& entry = MessageCatalog::get(diag.getMessageId());
+    json.key("fixHints");
+    json.beginArray();
+    for (const auto& hint : entry.fixHints) {
+        json.value(hint, locale);
+    }
+    json.endArray();
+    json.key("escapePaths");
+    json.beginArray();
+    for (const auto& escape : entry.escapePaths) {
+        json.value(escape, locale);
+    }
+    json.endArray();
+}
+
+} // namespace
+
+// JSONBuffer Implementation / JSONBuffer 实现
+
+void JSONBuffer::key(std::string_view name) {
+    separate();
+    buffer_ += '"';
+    appendEscaped(name);
+    buffer_ += "\":";
+    afterKey_ = true;
+}
+
+void JSONBuffer::value(std::string_view text) {
+    separate();
+    buffer_ += '"';
+    appendEscaped(text);
+    buffer_ += '"';
+}
+
+void JSONBuffer::value(unsigned number) {
+    separate();
+    char digits[16];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    buffer_.append(digits, result.ptr);
+}
+
+void JSONBuffer::value(const LocalizedText& text, Locale locale) {
+    scratch_.clear();
+    MessageCatalog::renderTo(scratch_, text, locale);
+    value(scratch_);
+}
+
+void JSONBuffer::message(const Diagnostic& diag, Locale locale) {
+    scratch_.clear();
+    diag.appendMessage(scratch_, locale);
+    value(scratch_);
+}
+
+void JSONBuffer::flushTo(llvm::raw_ostream& os) {
+    os.write(buffer_.data(), buffer_.size());
+    buffer_.clear();
+    first_ = true;
+    afterKey_ = false;
+}
+
+void JSONBuffer::separate() {
+    if (afterKey_) {
+        afterKey_ = false;
+        return;
+    }
+    if (!first_) {
+        buffer_ += ',';
+    }
+    first_ = false;
+}
+
+void JSONBuffer::appendEscaped(std::string_view text) {
+    static const char HEX[] = "0123456789abcdef";
+    for (char c : text) {
+        switch (c) {
+            case '"':
+                buffer_ += "\\\"";
+                break;
+            case '\\':
+                buffer_ += "\\\\";
+                break;
+            case '\n':
+                buffer_ += "\\n";
+                break;
+            case '\r':
+                buffer_ += "\\r";
+                break;
+            case '\t':
+                buffer_ += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    buffer_ += "\\u00";
+                    buffer_ += HEX[(c >> 4) & 0xf];
+                    buffer_ += HEX[c & 0xf];
+                } else {
+                    buffer_ += c;   // UTF-8 passes through / UTF-8 原样通过
+                }
+                break;
+        }
+    }
+}
+
+// JSONLinesSink Implementation / JSONLinesSink 实现
+
+void JSONLinesSink::handle(const Diagnostic& diag) {
+    const auto& location = diag.getLocation();
+    json_.beginObject();
+    json_.key("file");
+    json_.value(location.getFilename());
+    json_.key("line");
+    json_.value(location.line);
+    json_.key("column");
+    json_.value(location.column);
+    json_.key("severity");
+    json_.value(getSeverityName(diag.getSeverity()));
+    json_.key("ruleId");
+    json_.value(diag.getRuleId());
+    json_.key("category");
+    json_.value(getCategoryName(diag.getCategory()));
+    json_.key("message");
+    json_.message(diag, locale_);
+    writeHints(json_, diag, locale_);
+    json_.endObject();
+    json_.raw("\n");
+    json_.flushTo(os_);
+}
+
+// SARIFSink Implementation / SARIFSink 实现
+
+SARIFSink::SARIFSink(llvm::raw_ostream& os, Locale locale)
+    : os_(os)
+    , locale_(locale) {
+    os_ << "{\"$schema\":\"" << SARIF_SCHEMA << "\",\"version\":\"2.1.0\","
+        << "\"runs\":[{\"results\":[";
+}
+
+void SARIFSink::handle(const Diagnostic& diag) {
+    const auto& location = diag.getLocation();
+    if (!firstResult_) {
+        json_.raw(",");
+    }
+    firstResult_ = false;
+    
+    json_.beginObject();
+    json_.key("ruleId");
+    json_.value(diag.getRuleId());
+    json_.key("level");
+    json_.value(getSeverityName(diag.getSeverity()));
+    json_.key("message");
+    json_.beginObject();
+    json_.key("text");
+    json_.message(diag, locale_);
+    json_.endObject();
+    
+    json_.key("locations");
+    json_.beginArray();
+    json_.beginObject();
+    json_.key("physicalLocation");
+    json_.beginObject();
+    json_.key("artifactLocation");
+    json_.beginObject();
+    json_.key("uri");
+    json_.value(toFileURI(location.getFilename()));
+    json_.endObject();
+    json_.key("region");
+    json_.beginObject();
+    json_.key("startLine");
+    json_.value(location.line);
+    json_.key("startColumn");
+    json_.value(location.column);
+    json_.endObject();
+    json_.endObject();
+    json_.endObject();
+    json_.endArray();
+    
+    // Hints are prose, not edits, so they go in the property bag
+    // 建议是文字而非编辑，因此放在属性包中
+    json_.key("properties");
+    json_.beginObject();
+    json_.key("category");
+    json_.value(getCategoryName(diag.getCategory()));
+    writeHints(json_, diag, locale_);
+    json_.endObject();
+    json_.endObject();
+    json_.flushTo(os_);
+    
+    ruleIds_.insert(diag.getRuleId());
+}
+
+void SARIFSink::finish() {
+    if (finished_) {
+        return;
+    }
+    finished_ = true;
+    
+    json_.raw("],\"tool\":");
+    json_.beginObject();
+    json_.key("driver");
+    json_.beginObject();
+    json_.key("name");
+    json_.value("tcc-check");
+    json_.key("version");
+    json_.value(VERSION);
+    json_.key("rules");
+    json_.beginArray();
+    for (const auto& ruleId : ruleIds_) {
+        json_.beginObject();
+        json_.key("id");
+        json_.value(ruleId);
+        json_.endObject();
+    }
+    json_.endArray();
+    json_.endObject();
+    json_.endObject();
+    json_.raw("}]}\n");
+    json_.flushTo(os_);
+}
+
+std::unique_ptr<DiagnosticSink> createOutputSink(OutputFormat format,
+                                                 llvm::raw_ostream& os,
+                                                 Locale locale) {
+    switch (format) {
+        case OutputFormat::SARIF:
+            return std::make_unique<SARIFSink>(os, locale);
+        case OutputFormat::JSONLines:
+            return std::make_unique<JSONLinesSink>(os, locale);
+        case OutputFormat::Text:
+            break;
+    }
+    return std::make_unique<TextDiagnosticSink>(os, locale);
+}
+
+} // namespace tcc
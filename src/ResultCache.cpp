@@ -0,0 +1,329 @@
+﻿// Tough C Profiler - Result Cache Implementation
+// Tough C 分析器 - 结果缓存实现
+
+#include "tcc/ResultCache.h"
+
+#include <clang/Basic/Diagnostic.h>
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/FrontendAction.h>
+#include <clang/Frontend/Utils.h>
+#include <clang/Lex/Preprocessor.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace tcc {
+
+namespace {
+
+// Entry format tag, bump when the layout changes / 条目格式标记，布局变化时递增
+constexpr const char* ENTRY_MAGIC = "TCCR2";
+constexpr const char* ENTRY_EXTENSION = ".tccr";
+
+// Hash a length-prefixed field so adjacent fields cannot alias
+// 以长度前缀哈希字段，避免相邻字段混淆
+void hashField(llvm::MD5& hash, llvm::StringRef field) {
+    uint64_t length = field.size();
+    hash.update(llvm::ArrayRef<uint8_t>(reinterpret_cast<const uint8_t*>(&length),
+                                        sizeof(length)));
+    hash.update(field);
+}
+
+// Preprocess the TU and hash its token stream without building an AST
+// 预处理翻译单元并哈希其记号流，不构建 AST
+class TokenHashAction : public clang::PreprocessorFrontendAction {
+public:
+    TokenHashAction(llvm::MD5& hash, std::vector<std::string>* dependencies)
+        : hash_(hash), dependencies_(dependencies) {}
+
+protected:
+    bool BeginInvocation(clang::CompilerInstance& ci) override {
+        if (dependencies_) {
+            collector_ = std::make_shared<clang::DependencyCollector>();
+            ci.addDependencyCollector(collector_);
+        }
+        return true;
+    }
+    
+    void EndSourceFileAction() override {
+        if (collector_) {
+            auto files = collector_->getDependencies();
+            dependencies_->assign(files.begin(), files.end());
+        }
+    }
+    
+    void ExecuteAction() override {
+        auto& pp = getCompilerInstance().getPreprocessor();
+        pp.EnterMainSourceFile();
+        
+        clang::Token token;
+        llvm::SmallString<64> buffer;
+        do {
+            pp.Lex(token);
+            bool invalid = false;
+            llvm::StringRef spelling = pp.getSpelling(token, buffer, &invalid);
+            if (!invalid) {
+                hashField(hash_, spelling);
+            }
+        } while (token.isNot(clang::tok::eof));
+    }
+
+private:
+    llvm::MD5& hash_;
+    std::vector<std::string>* dependencies_;
+    std::shared_ptr<clang::DependencyCollector> collector_;
+};
+
+class TokenHashActionFactory : public clang::tooling::FrontendActionFactory {
+public:
+    TokenHashActionFactory(llvm::MD5& hash, std::vector<std::string>* dependencies)
+        : hash_(hash), dependencies_(dependencies) {}
+    
+    std::unique_ptr<clang::FrontendAction> create() override {
+        return std::make_unique<TokenHashAction>(hash_, dependencies_);
+    }
+
+private:
+    llvm::MD5& hash_;
+    std::vector<std::string>* dependencies_;
+};
+
+// Length-prefixed string: "<size>:<bytes>\n" / 长度前缀字符串
+void writeString(std::ostream& os, const std::string& value) {
+    os << value.size() << ':' << value << '\n';
+}
+
+bool readString(std::istream& is, std::string& value) {
+    size_t size = 0;
+    char separator = 0;
+    if (!(is >> size) || !is.get(separator) || separator != ':') {
+        return false;
+    }
+    value.resize(size);
+    if (!is.read(&value[0], static_cast<std::streamsize>(size))) {
+        return false;
+    }
+    return static_cast<bool>(is.get(separator)) && separator == '\n';
+}
+
+bool readStrings(std::istream& is, std::vector<std::string>& values) {
+    size_t count = 0;
+    if (!(is >> count)) {
+        return false;
+    }
+    values.resize(count);
+    for (auto& value : values) {
+        if (!readString(is, value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void writeStrings(std::ostream& os, const std::vector<std::string>& values) {
+    os << values.size() << '\n';
+    for (const auto& value : values) {
+        writeString(os, value);
+    }
+}
+
+} // namespace
+
+ResultCache::ResultCache(std::string directory, uint64_t maxBytes)
+    : directory_(std::move(directory))
+    , maxBytes_(maxBytes) {
+    std::error_code ec;
+    fs::create_directories(directory_, ec);
+}
+
+std::string ResultCache::computeKey(const clang::tooling::CompilationDatabase& compilations,
+                                    const std::string& file,
+                                    const std::string& ruleSet,
+                                    std::vector<std::string>* dependencies) {
+    llvm::MD5 hash;
+    hashField(hash, VERSION);
+    hashField(hash, ruleSet);
+    
+    // Compiler flags / 编译器标志
+    for (const auto& command : compilations.getCompileCommands(file)) {
+        hashField(hash, command.Directory);
+        for (const auto& arg : command.CommandLine) {
+            hashField(hash, arg);
+        }
+    }
+    
+    // Main file bytes: tokens alone miss line shifts and @tcc comments
+    // 主文件内容：仅凭记号无法察觉行号偏移和 @tcc 注释
+    auto buffer = llvm::MemoryBuffer::getFile(file);
+    if (!buffer) {
+        return std::string();
+    }
+    hashField(hash, (*buffer)->getBuffer());
+    
+    // Preprocessed token stream covers every included header
+    // 预处理记号流覆盖所有被包含的头文件
+    clang::tooling::ClangTool tool(compilations, {file});
+    clang::IgnoringDiagConsumer ignoreDiagnostics;
+    tool.setDiagnosticConsumer(&ignoreDiagnostics);
+    TokenHashActionFactory factory(hash, dependencies);
+    if (tool.run(&factory) != 0) {
+        return std::string();
+    }
+    
+    llvm::MD5::MD5Result result;
+    hash.final(result);
+    return result.digest().str().str();
+}
+
+bool ResultCache::lookup(const std::string& key, DiagnosticEngine& diagnostics) const {
+    std::string path = entryPath(key);
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    std::string magic;
+    size_t count = 0;
+    if (!std::getline(file, magic) || magic != ENTRY_MAGIC || !(file >> count)) {
+        return false;
+    }
+    
+    DiagnosticEngine loaded;
+    for (size_t i = 0; i < count; ++i) {
+        unsigned severity = 0;
+        unsigned category = 0;
+        size_t message = 0;
+        unsigned line = 0;
+        unsigned column = 0;
+        std::string ruleId;
+        std::string filename;
+        std::vector<std::string> arguments;
+        
+        // Enums index counters and tables, so a corrupt entry is a miss
+        // 枚举值用于索引计数器和表，因此损坏的条目视为未命中
+        if (!(file >> severity >> category >> message >> line >> column) ||
+            severity > static_cast<unsigned>(Severity::Note) ||
+            category > static_cast<unsigned>(RuleCategory::TypeSafety) ||
+            message >= static_cast<size_t>(MessageId::Count) ||
+            !readString(file, ruleId) ||
+            !readString(file, filename) ||
+            !readStrings(file, arguments) ||
+            arguments.size() > Diagnostic::MAX_ARGUMENTS) {
+            return false;
+        }
+        
+        loaded.report(Diagnostic(static_cast<Severity>(severity),
+                                 static_cast<MessageId>(message),
+                                 SourceLocation(filename, line, column),
+                                 static_cast<RuleCategory>(category),
+                                 ruleId,
+                                 {arguments.begin(), arguments.end()}));
+    }
+    
+    // Refresh recency for eviction / 刷新最近使用时间以便淘汰
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    
+    diagnostics.append(std::move(loaded));
+    return true;
+}
+
+void ResultCache::store(const std::string& key, const DiagnosticEngine& diagnostics) const {
+    std::ostringstream entry;
+    const auto& diags = diagnostics.getDiagnostics();
+    entry << ENTRY_MAGIC << '\n' << diags.size() << '\n';
+    for (const auto& diag : diags) {
+        const auto& location = diag.getLocation();
+        entry << static_cast<int>(diag.getSeverity()) << ' '
+              << static_cast<int>(diag.getCategory()) << ' '
+              << static_cast<int>(diag.getMessageId()) << ' '
+              << location.line << ' ' << location.column << '\n';
+        writeString(entry, diag.getRuleId());
+        writeString(entry, location.getFilename());
+        auto arguments = diag.getArguments();
+        entry << arguments.size() << '\n';
+        for (auto argument : arguments) {
+            writeString(entry, std::string(argument));
+        }
+    }
+    
+    // Write to a private temp file, then rename into place so readers
+    // never see a partial entry / 先写私有临时文件再重命名，读者不会看到半写条目
+    std::string path = entryPath(key);
+    int fd = -1;
+    llvm::SmallString<256> tempPath;
+    if (llvm::sys::fs::createUniqueFile(path + "-%%%%%%%%.tmp", fd, tempPath)) {
+        return;
+    }
+    
+    {
+        llvm::raw_fd_ostream file(fd, /*shouldClose=*/true);
+        file << entry.str();
+        file.close();
+        if (file.has_error()) {
+            file.clear_error();
+            llvm::sys::fs::remove(tempPath);
+            return;
+        }
+    }
+    
+    if (llvm::sys::fs::rename(tempPath, path)) {
+        llvm::sys::fs::remove(tempPath);
+    }
+}
+
+void ResultCache::evict() const {
+    struct Entry {
+        fs::path path;
+        uint64_t size;
+        fs::file_time_type lastUse;
+    };
+    
+    std::vector<Entry> entries;
+    uint64_t totalBytes = 0;
+    std::error_code ec;
+    for (const auto& item : fs::directory_iterator(directory_, ec)) {
+        if (!item.is_regular_file(ec) || item.path().extension() != ENTRY_EXTENSION) {
+            continue;
+        }
+        Entry entry{item.path(), item.file_size(ec), item.last_write_time(ec)};
+        totalBytes += entry.size;
+        entries.push_back(std::move(entry));
+    }
+    
+    if (totalBytes <= maxBytes_) {
+        return;
+    }
+    
+    // Oldest first / 最旧的优先
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.lastUse < b.lastUse;
+    });
+    
+    for (const auto& entry : entries) {
+        if (totalBytes <= maxBytes_) {
+            break;
+        }
+        if (fs::remove(entry.path, ec)) {
+            totalBytes -= entry.size;
+        }
+    }
+}
+
+std::string ResultCache::entryPath(const std::string& key) const {
+    return (fs::path(directory_) / (key + ENTRY_EXTENSION)).string();
+}
+
+} // namespace tcc
@@ -2,27 +2,157 @@
 // Tough C 分析器 - 规则实现
 
 #include "tcc/Rule.h"
+#include "tcc/ASTVisitor.h"
+#include "tcc/MatcherRule.h"
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/DynamicLibrary.h>
+#include <llvm/Support/FileSystem.h>
+
 #include <algorithm>
+#include <array>
+#include <chrono>
 
 namespace tcc {
 
+namespace {
+
+// "<path> <size> <mtime>" of a library, empty if it cannot be read
+// 库的 "<路径> <大小> <修改时间>"，无法读取时为空
+std::string getLibraryIdentity(const std::string& realPath) {
+    llvm::sys::fs::file_status status;
+    if (llvm::sys::fs::status(realPath, status)) {
+        return std::string();
+    }
+    auto modified = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        status.getLastModificationTime().time_since_epoch());
+    return realPath + " " + std::to_string(status.getSize()) + " " +
+           std::to_string(modified.count());
+}
+
+} // namespace
+
+// RuleDispatchTable Implementation / RuleDispatchTable 实现
+
+RuleDispatchTable::RuleDispatchTable() = default;
+RuleDispatchTable::~RuleDispatchTable() = default;
+
+void RuleDispatchTable::addRule(Rule* rule, RuleStats* stats) {
+    rule->subscribe(*this, stats);
+}
+
+RuleMatchFinder& RuleDispatchTable::getOrCreateMatchFinder() {
+    if (!matchFinder_) {
+        matchFinder_ = std::make_unique<RuleMatchFinder>();
+    }
+    return *matchFinder_;
+}
+
+// Rule Implementation / Rule 实现
+
+void Rule::check(clang::ASTContext& context, DiagnosticEngine& diagnostics,
+                 const CancellationToken& cancel) {
+    if (getNodeInterests() == 0) {
+        return;
+    }
+    
+    // Same dispatcher as the engine, subscribed to this rule only
+    // 与引擎相同的分发器，仅订阅此规则
+    RuleDispatchTable dispatch;
+    dispatch.addRule(this);
+    
+    TCCASTVisitor visitor(context, dispatch, diagnostics, cancel);
+    visitor.TraverseDecl(context.getTranslationUnitDecl());
+    visitor.runMatchers();
+}
+
+void Rule::report(DiagnosticEngine& diagnostics, clang::ASTContext& /*context*/,
+                  clang::SourceLocation loc, Severity severity, MessageId message,
+                  const std::vector<std::string_view>& arguments) const {
+    std::array<StringId, Diagnostic::MAX_ARGUMENTS> handles{};
+    size_t count = std::min(arguments.size(), handles.size());
+    for (size_t i = 0; i < count; ++i) {
+        handles[i] = StringPool::global().intern(arguments[i]);
+    }
+    diagnostics.report(Diagnostic(severity, message,
+                                  SourceLocation::unresolved(loc.getRawEncoding()),
+                                  category_, idHandle_, handles.data(), count));
+}
+
 RuleRegistry& RuleRegistry::instance() {
     static RuleRegistry registry;
     return registry;
 }
 
-void RuleRegistry::registerRule(std::unique_ptr<Rule> rule) {
-    rules_.push_back(std::move(rule));
+void RuleRegistry::registerFactory(RuleFactory factory) {
+    (loading_ ? loading_->factories : linked_).push_back(factory);
 }
 
-std::vector<Rule*> RuleRegistry::getRulesByCategory(RuleCategory category) const {
-    std::vector<Rule*> result;
-    for (const auto& rule : rules_) {
-        if (rule->getCategory() == category) {
-            result.push_back(rule.get());
+const RulePlugin* RuleRegistry::loadPlugin(const std::string& path, std::string& error) {
+    // The loader keeps one handle per library, so key plugins on the real path
+    // 加载器对每个库只保留一个句柄，因此以真实路径作为插件的键
+    llvm::SmallString<256> realPath;
+    if (auto ec = llvm::sys::fs::real_path(path, realPath)) {
+        error = path + ": " + ec.message();
+        return nullptr;
+    }
+    std::string identity = getLibraryIdentity(realPath.str().str());
+    
+    // A library stays loaded for the process, so a long-lived process such
+    // as tcc-checkd cannot pick up a rebuilt plugin
+    // 库在进程内保持加载，因此 tcc-checkd 等长期运行的进程无法使用重新构建的插件
+    for (const auto& plugin : plugins_) {
+        if (plugin->path == realPath.str()) {
+            if (plugin->identity != identity) {
+                error = path + ": changed since it was loaded; restart the process / "
+                        "自加载以来已改变；请重启进程";
+                return nullptr;
+            }
+            return plugin.get();
+        }
+    }
+    
+    // Static initializers run inside the load and register into `plugin`
+    // 静态初始化器在加载过程中运行，并注册到 `plugin`
+    auto plugin = std::make_unique<RulePlugin>();
+    plugin->path = realPath.str().str();
+    plugin->identity = identity;
+    loading_ = plugin.get();
+    auto library = llvm::sys::DynamicLibrary::getPermanentLibrary(plugin->path.c_str(), &error);
+    loading_ = nullptr;
+    if (!library.isValid()) {
+        error = path + ": " + error;
+        return nullptr;
+    }
+    
+    using VersionFunction = unsigned (*)();
+    auto version = reinterpret_cast<VersionFunction>(
+        library.getAddressOfSymbol("tccRulePluginApiVersion"));
+    if (!version || version() != RULE_PLUGIN_API_VERSION) {
+        error = path + ": not a rule plugin for API version " +
+                std::to_string(RULE_PLUGIN_API_VERSION) + " / 不是 API 版本 " +
+                std::to_string(RULE_PLUGIN_API_VERSION) + " 的规则插件";
+        return nullptr;
+    }
+    if (plugin->factories.empty()) {
+        error = path + ": registers no rules / 未注册任何规则";
+        return nullptr;
+    }
+    
+    // A rule walking the TU on its own would add a whole traversal per file
+    // 自行遍历翻译单元的规则会使每个文件多一次完整遍历
+    for (RuleFactory factory : plugin->factories) {
+        auto rule = factory();
+        if (rule->getNodeInterests() == 0) {
+            error = path + ": rule " + rule->getId() +
+                    " has no node interests; derive it from NodeRule or MatcherRule / "
+                    "规则 " + rule->getId() + " 没有节点兴趣；请派生自 NodeRule 或 MatcherRule";
+            return nullptr;
         }
     }
-    return result;
+    
+    plugins_.push_back(std::move(plugin));
+    return plugins_.back().get();
 }
 
 } // namespace tcc
@@ -6,6 +6,15 @@
 #include "tcc/LifetimeRules.h"
 #include "tcc/ConcurrencyRules.h"
 #include "tcc/ASTVisitor.h"
+#include "tcc/SourceManagerResolver.h"
+
+#include <clang/Basic/SourceManager.h>
+
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <optional>
+#include <thread>
 
 namespace tcc {
 
@@ -18,7 +27,8 @@ void RuleEngine::initializeDefaultRules() {
     if (ownershipEnabled_) {
         addRule(std::make_unique<ForbidNewRule>());
         addRule(std::make_unique<ForbidDeleteRule>());
-        addRule(std::make_unique<ForbidMallocFreeRule>());
+        addRule(std::make_unique<ForbidMallocFreeRule>(
+            apiCatalog_ ? *apiCatalog_ : ApiCatalog::builtin()));
         addRule(std::make_unique<RawOwningPointerRule>());
     }
     
@@ -37,29 +47,288 @@ void RuleEngine::initializeDefaultRules() {
         addRule(std::make_unique<ForbidRawPtrThreadSharingRule>());
         addRule(std::make_unique<RequireAtomicForSharedCounterRule>());
     }
+    
+    for (RuleFactory factory : RuleRegistry::instance().getLinkedFactories()) {
+        addRule(factory());
+    }
+}
+
+void RuleEngine::addPluginRules(const RulePlugin& plugin) {
+    // A rebuilt plugin may keep its rule IDs but not its results
+    // 重新构建的插件可能保留规则 ID，但结果不同
+    pluginIdentities_ += plugin.identity;
+    pluginIdentities_ += ';';
+    for (RuleFactory factory : plugin.factories) {
+        addRule(factory());
+    }
 }
 
 void RuleEngine::addRule(std::unique_ptr<Rule> rule) {
     rules_.push_back(std::move(rule));
+    ruleStats_.emplace_back();
 }
 
 void RuleEngine::analyze(clang::ASTContext& context, DiagnosticEngine& diagnostics) {
-    // Create AST visitor / 创建 AST 访问者
-    TCCASTVisitor visitor(context, rules_, diagnostics);
+    CancellationToken never;
+    analyze(context, diagnostics, getCategoryMask(TCCConfig()), never);
+}
+
+void RuleEngine::analyze(clang::ASTContext& context, DiagnosticEngine& diagnostics,
+                         CategoryMask categories, const CancellationToken& cancel) {
+    // Rules of selected categories by cost tier; within a tier the lowest
+    // cost per call measured on earlier TUs goes first. The order differs
+    // between runs and -j workers, so diagnostics are sorted at the end.
+    // 所选类别的规则按开销层级分组；同一层级内，在之前的翻译单元上测得的每次调用开销最低的在前。
+    // 该顺序在不同运行和 -j 工作线程之间可能不同，因此诊断在最后排序。
+    std::array<std::vector<size_t>, RULE_COST_COUNT> tiers;
+    for (size_t i = 0; i < rules_.size(); ++i) {
+        // Masked-out categories are never traversed / 被屏蔽的类别从不遍历
+        if (categories & categoryBit(rules_[i]->getCategory())) {
+            tiers[static_cast<size_t>(rules_[i]->getCost())].push_back(i);
+        }
+    }
+    for (auto& tier : tiers) {
+        std::stable_sort(tier.begin(), tier.end(), [&](size_t a, size_t b) {
+            return getCostPerCall(a) < getCostPerCall(b);
+        });
+    }
     
-    // Traverse the entire AST / 遍历整个 AST
-    visitor.TraverseDecl(context.getTranslationUnitDecl());
+    // Limit every traversal to main-file declarations so header subtrees
+    // (<thread>, <vector>, ...) are never entered
+    // 将所有遍历限制在主文件声明内，从不进入头文件子树
+    auto previousScope = context.getTraversalScope();
+    context.setTraversalScope(collectMainFileDecls(context));
     
-    // Run all enabled rules / 运行所有启用的规则
-    for (const auto& rule : rules_) {
-        // Check if rule category is enabled / 检查规则类别是否启用
-        if (!isCategoryEnabled(rule->getCategory())) {
+    // Rules store raw locations; they are resolved once, below
+    // 规则只存储原始位置；在下方统一解析一次
+    SourceManagerResolver resolver(context.getSourceManager());
+    diagnostics.attachResolver(&resolver);
+    
+    // One pass runs every tier, cheapest first. Only gate mode with
+    // expensive rules selected holds them back for a second pass, which a
+    // TU the cheaper tiers rejected never pays for.
+    // 一次扫描运行所有层级，最廉价的优先。只有门禁模式且选中了昂贵规则时，才将其留到第二次扫描，
+    // 已被较廉价层级拒绝的翻译单元不再为其付出开销。
+    auto& expensive = tiers[static_cast<size_t>(RuleCost::Expensive)];
+    bool staged = gate_ && !expensive.empty();
+    std::vector<size_t> selected;
+    for (const auto& tier : tiers) {
+        if (!staged || &tier != &expensive) {
+            selected.insert(selected.end(), tier.begin(), tier.end());
+        }
+    }
+    
+    size_t errorsBefore = diagnostics.getErrorCount();
+    runRules(context, diagnostics, selected, cancel);
+    if (staged && diagnostics.getErrorCount() == errorsBefore) {
+        runRules(context, diagnostics, expensive, cancel);
+    }
+    
+    diagnostics.resolveLocations();
+    diagnostics.sortByLocation();
+    context.setTraversalScope(previousScope);
+}
+
+void RuleEngine::runRules(clang::ASTContext& context, DiagnosticEngine& diagnostics,
+                          const std::vector<size_t>& rules, const CancellationToken& cancel) {
+    std::vector<size_t> traversalRules;
+    std::vector<size_t> standaloneRules;
+    for (size_t i : rules) {
+        if (rules_[i]->getNodeInterests() != 0) {
+            traversalRules.push_back(i);
+        } else {
+            standaloneRules.push_back(i);
+        }
+    }
+    
+    // Single traversal feeding every subscribed rule, split across threads
+    // when enabled / 单次遍历为所有订阅规则提供节点，启用时拆分到多个线程
+    if (!traversalRules.empty() && !traverseSharded(context, diagnostics, traversalRules, cancel)) {
+        RuleDispatchTable dispatch;
+        for (size_t i : traversalRules) {
+            dispatch.addRule(rules_[i].get(), profiling_ ? &ruleStats_[i] : nullptr);
+        }
+        if (!dispatch.empty()) {
+            // A table of matcher rules only has nothing to visit / 只有匹配器规则的分发表无需遍历
+            TCCASTVisitor visitor(context, dispatch, diagnostics, cancel);
+            if (dispatch.hasHooks()) {
+                visitor.TraverseDecl(context.getTranslationUnitDecl());
+            }
+            visitor.runMatchers();
+        }
+    }
+    
+    // Rules without node interests run on their own, always timed: one
+    // stopwatch per TU is cheap and feeds the order within a tier
+    // 没有节点兴趣的规则单独运行并始终计时：每个翻译单元一个秒表开销很小，并为层级内的排序提供数据
+    for (size_t i : standaloneRules) {
+        if (cancel.isCancelled()) {
+            break;
+        }
+        
+        size_t before = diagnostics.getDiagnostics().size();
+        Stopwatch stopwatch;
+        rules_[i]->check(context, diagnostics, cancel);
+        ruleStats_[i].wallSeconds += stopwatch.wallSeconds();
+        ruleStats_[i].cpuSeconds += stopwatch.cpuSeconds();
+        ruleStats_[i].runs += 1;
+        ruleStats_[i].diagnostics += diagnostics.getDiagnostics().size() - before;
+    }
+}
+
+double RuleEngine::getCostPerCall(size_t index) const {
+    const auto& stats = ruleStats_[index];
+    uint64_t calls = stats.nodes + stats.runs;
+    return calls > 0 ? stats.wallSeconds / static_cast<double>(calls) : 0.0;
+}
+
+bool RuleEngine::traverseSharded(clang::ASTContext& context, DiagnosticEngine& diagnostics,
+                                 const std::vector<size_t>& traversalRules,
+                                 const CancellationToken& cancel) {
+    // Lazy loading from a PCH would write to the AST while shards read it
+    // 从 PCH 延迟加载会在分片读取 AST 时写入 AST
+    if (traversalThreads_ < 2 || context.getExternalSource()) {
+        return false;
+    }
+    
+    std::vector<clang::Decl*> units = collectShardUnits(context.getTraversalScope());
+    size_t shardCount = std::min<size_t>(traversalThreads_, units.size() / MIN_UNITS_PER_SHARD);
+    if (shardCount < 2) {
+        return false;
+    }
+    
+    // Rules keep per-TU state, so every shard checks with its own copies
+    // 规则持有每个翻译单元的状态，因此每个分片使用自己的副本检查
+    struct Shard {
+        std::vector<std::unique_ptr<Rule>> rules;
+        std::vector<RuleStats> stats;   // Parallel to traversalRules / 与 traversalRules 平行
+        RuleDispatchTable dispatch;
+        DiagnosticEngine diagnostics;
+    };
+    std::vector<Shard> shards(shardCount);
+    for (auto& shard : shards) {
+        shard.stats.resize(traversalRules.size());
+        for (size_t r = 0; r < traversalRules.size(); ++r) {
+            auto copy = rules_[traversalRules[r]]->clone();
+            if (!copy) {
+                return false;
+            }
+            shard.dispatch.addRule(copy.get(), profiling_ ? &shard.stats[r] : nullptr);
+            shard.rules.push_back(std::move(copy));
+        }
+    }
+    
+    // Matcher rules alone leave the shards nothing to walk / 只有匹配器规则时分片无可遍历
+    if (!shards.front().dispatch.hasHooks()) {
+        return false;
+    }
+    
+    // Shards cancel on the parent's fail-fast token and baseline, so an
+    // error in one stops the others. Checking the baseline resolves
+    // locations, which shares the main-file filter's SourceManager lock.
+    // 分片使用父引擎的快速失败令牌和基线取消，因此一个分片中的错误会停止其他分片。
+    // 检查基线需要解析位置，与主文件过滤器共用 SourceManager 锁。
+    std::mutex sourceManagerMutex;
+    MainFileFilter mainFile(context.getSourceManager(), sourceManagerMutex);
+    std::optional<LockedResolver> resolver;
+    if (diagnostics.getResolver()) {
+        resolver.emplace(*diagnostics.getResolver(), sourceManagerMutex);
+    }
+    for (auto& shard : shards) {
+        shard.diagnostics.shareCancellation(diagnostics, resolver ? &*resolver : nullptr);
+    }
+    DiagnosticEngine matchDiagnostics;
+    matchDiagnostics.shareCancellation(diagnostics, resolver ? &*resolver : nullptr);
+    
+    // Contiguous chunks, so merging in shard order keeps traversal order
+    // 连续的分块，因此按分片顺序合并可保持遍历顺序
+    auto runShard = [&](size_t index) {
+        Shard& shard = shards[index];
+        TCCASTVisitor visitor(context, shard.dispatch, shard.diagnostics, cancel, &mainFile);
+        size_t end = units.size() * (index + 1) / shardCount;
+        for (size_t u = units.size() * index / shardCount; u < end; ++u) {
+            if (!visitor.TraverseDecl(units[u])) {
+                break;
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t index = 1; index < shardCount; ++index) {
+        threads.emplace_back(runShard, index);
+    }
+    runShard(0);
+    
+    // The matcher pass walks the whole scope with one memo cache, so it is
+    // not split; the first shard's matcher rules run it on this thread, and
+    // the other shards' copies stay idle
+    // 匹配器扫描以一个记忆化缓存遍历整个范围，因此不拆分；由第一个分片的匹配器规则在本线程上运行，
+    // 其他分片的副本保持空闲
+    TCCASTVisitor matchVisitor(context, shards.front().dispatch, matchDiagnostics, cancel);
+    matchVisitor.runMatchers();
+    
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    // Node rule results first, as on a single thread / 先合并节点规则结果，与单线程时一致
+    for (auto& shard : shards) {
+        diagnostics.append(std::move(shard.diagnostics));
+        for (size_t r = 0; r < traversalRules.size(); ++r) {
+            ruleStats_[traversalRules[r]].add(shard.stats[r]);
+        }
+    }
+    diagnostics.append(std::move(matchDiagnostics));
+    return true;
+}
+
+std::vector<clang::Decl*> RuleEngine::collectShardUnits(const std::vector<clang::Decl*>& decls) {
+    // Descend into namespaces and extern "C" blocks so a TU wrapped in one
+    // namespace still splits; other declarations stay whole
+    // 进入命名空间和 extern "C" 块，使整体包在一个命名空间中的翻译单元仍可拆分；其他声明保持完整
+    std::vector<clang::Decl*> units;
+    std::vector<clang::Decl*> pending(decls.rbegin(), decls.rend());
+    while (!pending.empty()) {
+        clang::Decl* decl = pending.back();
+        pending.pop_back();
+        if (!llvm::isa<clang::NamespaceDecl, clang::LinkageSpecDecl>(decl)) {
+            units.push_back(decl);
             continue;
         }
         
-        // Execute rule / 执行规则
-        rule->check(context, diagnostics);
+        // Same children RecursiveASTVisitor would traverse / 与 RecursiveASTVisitor 遍历的子节点相同
+        std::vector<clang::Decl*> children;
+        for (auto* child : llvm::cast<clang::DeclContext>(decl)->noload_decls()) {
+            auto* record = llvm::dyn_cast<clang::CXXRecordDecl>(child);
+            if (!llvm::isa<clang::BlockDecl, clang::CapturedDecl>(child) &&
+                !(record && record->isLambda())) {
+                children.push_back(child);
+            }
+        }
+        pending.insert(pending.end(), children.rbegin(), children.rend());
     }
+    return units;
+}
+
+std::vector<clang::Decl*> RuleEngine::collectMainFileDecls(clang::ASTContext& context) {
+    const auto& sm = context.getSourceManager();
+    auto mainFile = sm.getMainFileID();
+    
+    // Declarations from a PCH are never main-file; skip loading them
+    // 来自 PCH 的声明不会在主文件中；跳过加载
+    std::vector<clang::Decl*> decls;
+    for (auto* decl : context.getTranslationUnitDecl()->noload_decls()) {
+        auto loc = decl->getLocation();
+        if (loc.isInvalid()) {
+            continue;
+        }
+        
+        // Compare FileIDs instead of resolving presumed locations
+        // 比较 FileID 而不是解析 presumed 位置
+        if (sm.getFileID(sm.getExpansionLoc(loc)) == mainFile) {
+            decls.push_back(decl);
+        }
+    }
+    return decls;
 }
 
 void RuleEngine::enableCategory(RuleCategory category, bool enabled) {
@@ -91,6 +360,32 @@ bool RuleEngine::isCategoryEnabled(RuleCategory category) const {
     }
 }
 
+CategoryMask RuleEngine::getCategoryMask(const TCCConfig& config) const {
+    CategoryMask mask = 0;
+    if (ownershipEnabled_ && config.ownershipChecks) {
+        mask |= categoryBit(RuleCategory::Ownership);
+    }
+    if (lifetimeEnabled_ && config.lifetimeChecks) {
+        mask |= categoryBit(RuleCategory::Lifetime);
+    }
+    if (concurrencyEnabled_ && config.concurrencyChecks) {
+        mask |= categoryBit(RuleCategory::Concurrency);
+    }
+    return mask;
+}
+
+void RuleEngine::enableProfiling(bool enabled) {
+    profiling_ = enabled;
+}
+
+void RuleEngine::reportProfile(TimeReport& report) const {
+    for (size_t i = 0; i < rules_.size(); ++i) {
+        if (isCategoryEnabled(rules_[i]->getCategory())) {
+            report.addRule(rules_[i]->getId(), ruleStats_[i]);
+        }
+    }
+}
+
 size_t RuleEngine::getRuleCount() const {
     return rules_.size();
 }
@@ -105,4 +400,28 @@ size_t RuleEngine::getActiveRuleCount() const {
     return count;
 }
 
+std::string RuleEngine::getRuleSetSignature() const {
+    std::string signature;
+    for (const auto& rule : rules_) {
+        if (isCategoryEnabled(rule->getCategory())) {
+            signature += rule->getId();
+            signature += ';';
+        }
+    }
+    if (apiCatalog_ && isCategoryEnabled(RuleCategory::Ownership)) {
+        signature += apiCatalog_->getSignature();
+    }
+    signature += pluginIdentities_;
+    
+    // Gate mode may skip expensive rules, so its results differ
+    // 门禁模式可能跳过昂贵规则，因此其结果不同
+    bool expensiveActive = std::any_of(rules_.begin(), rules_.end(), [&](const auto& rule) {
+        return rule->getCost() == RuleCost::Expensive && isCategoryEnabled(rule->getCategory());
+    });
+    if (gate_ && expensiveActive) {
+        signature += "gate;";
+    }
+    return signature;
+}
+
 } // namespace tcc
@@ -0,0 +1,322 @@
+﻿// Tough C Profiler - Binary Shard Results Implementation
+// Tough C 分析器 - 二进制分片结果实现
+
+#include "tcc/ShardFile.h"
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SwapByteOrder.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+
+namespace tcc {
+
+namespace {
+
+constexpr char SHARD_MAGIC[4] = {'T', 'C', 'C', 'S'};
+constexpr uint32_t SHARD_VERSION = 1;
+constexpr StringId NOT_INTERNED = std::numeric_limits<StringId>::max();
+
+uint64_t alignTo8(uint64_t size) {
+    return (size + 7) & ~uint64_t(7);
+}
+
+// Shared by the writer's sort and the reader's merge so both agree on order
+// 由写出端排序和读取端归并共用，保证两者顺序一致
+template <typename LeftStrings, typename RightStrings>
+int compareRecords(const ShardRecord& left, const LeftStrings& leftString,
+                   const ShardRecord& right, const RightStrings& rightString) {
+    if (int c = leftString(left.file).compare(rightString(right.file))) {
+        return c;
+    }
+    if (left.line != right.line) {
+        return left.line < right.line ? -1 : 1;
+    }
+    if (left.column != right.column) {
+        return left.column < right.column ? -1 : 1;
+    }
+    if (int c = leftString(left.ruleId).compare(rightString(right.ruleId))) {
+        return c;
+    }
+    if (left.message != right.message) {
+        return left.message < right.message ? -1 : 1;
+    }
+    if (left.argumentCount != right.argumentCount) {
+        return left.argumentCount < right.argumentCount ? -1 : 1;
+    }
+    for (uint8_t i = 0; i < left.argumentCount; ++i) {
+        if (int c = leftString(left.arguments[i]).compare(rightString(right.arguments[i]))) {
+            return c;
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+// ShardWriter Implementation / ShardWriter 实现
+
+ShardWriter::ShardWriter(std::string path)
+    : path_(std::move(path)) {}
+
+void ShardWriter::handle(const Diagnostic& diag) {
+    diagnostics_.push_back(diag);
+}
+
+void ShardWriter::finish() {
+    if (llvm::sys::IsBigEndianHost) {
+        error_ = "shards are little-endian only / 分片仅支持小端";
+        return;
+    }
+    
+    // Build the string table and fixed-size records / 构建字符串表和定长记录
+    std::unordered_map<StringId, uint32_t> indices;
+    std::vector<StringId> strings;   // Shard index -> pool ID / 分片索引 -> 池 ID
+    auto addString = [&](StringId id) {
+        auto inserted = indices.emplace(id, static_cast<uint32_t>(strings.size()));
+        if (inserted.second) {
+            strings.push_back(id);
+        }
+        return inserted.first->second;
+    };
+    
+    std::vector<ShardRecord> records;
+    records.reserve(diagnostics_.size());
+    for (const auto& diag : diagnostics_) {
+        ShardRecord record = {};
+        record.file = addString(diag.getLocation().file);
+        record.line = diag.getLocation().line;
+        record.column = diag.getLocation().column;
+        record.ruleId = addString(diag.getRuleIdHandle());
+        auto arguments = diag.getArguments();
+        for (auto argument : arguments) {
+            record.arguments[record.argumentCount++] =
+                addString(StringPool::global().intern(argument));
+        }
+        record.message = static_cast<uint16_t>(diag.getMessageId());
+        record.severity = static_cast<uint8_t>(diag.getSeverity());
+        record.category = static_cast<uint8_t>(diag.getCategory());
+        records.push_back(record);
+    }
+    std::vector<Diagnostic>().swap(diagnostics_);
+    
+    std::vector<std::string_view> table;
+    table.reserve(strings.size());
+    for (StringId id : strings) {
+        table.push_back(StringPool::global().get(id));
+    }
+    auto lookup = [&](uint32_t index) { return table[index]; };
+    std::sort(records.begin(), records.end(), [&](const ShardRecord& a, const ShardRecord& b) {
+        return compareRecords(a, lookup, b, lookup) < 0;
+    });
+    
+    ShardHeader header = {};
+    std::memcpy(header.magic, SHARD_MAGIC, sizeof(header.magic));
+    header.version = SHARD_VERSION;
+    header.stringCount = static_cast<uint32_t>(table.size());
+    header.recordCount = static_cast<uint32_t>(records.size());
+    
+    std::vector<ShardString> index;
+    index.reserve(table.size());
+    for (auto text : table) {
+        index.push_back({static_cast<uint32_t>(header.stringBytes),
+                         static_cast<uint32_t>(text.size())});
+        header.stringBytes += text.size();
+    }
+    
+    // Write to a private temp file, then rename into place
+    // 先写私有临时文件再重命名到位
+    int fd = -1;
+    llvm::SmallString<256> tempPath;
+    if (std::error_code ec = llvm::sys::fs::createUniqueFile(path_ + "-%%%%%%%%.tmp", fd, tempPath)) {
+        error_ = path_ + ": " + ec.message();
+        return;
+    }
+    
+    {
+        llvm::raw_fd_ostream file(fd, /*shouldClose=*/true);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(ShardString));
+        for (auto text : table) {
+            file.write(text.data(), text.size());
+        }
+        file.write_zeros(static_cast<unsigned>(alignTo8(header.stringBytes) - header.stringBytes));
+        file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(ShardRecord));
+        file.close();
+        if (file.has_error()) {
+            error_ = path_ + ": " + file.error().message();
+            file.clear_error();
+            llvm::sys::fs::remove(tempPath);
+            return;
+        }
+    }
+    
+    if (std::error_code ec = llvm::sys::fs::rename(tempPath, path_)) {
+        error_ = path_ + ": " + ec.message();
+        llvm::sys::fs::remove(tempPath);
+    }
+}
+
+// ShardReader Implementation / ShardReader 实现
+
+ShardReader::ShardReader() = default;
+ShardReader::~ShardReader() = default;
+ShardReader::ShardReader(ShardReader&&) noexcept = default;
+ShardReader& ShardReader::operator=(ShardReader&&) noexcept = default;
+
+bool ShardReader::open(const std::string& path, std::string& error) {
+    // Large files are mapped rather than read / 大文件采用映射而非读取
+    auto buffer = llvm::MemoryBuffer::getFile(path, /*IsText=*/false,
+                                              /*RequiresNullTerminator=*/false);
+    if (!buffer) {
+        error = path + ": " + buffer.getError().message();
+        return false;
+    }
+    
+    const char* data = (*buffer)->getBufferStart();
+    uint64_t size = (*buffer)->getBufferSize();
+    ShardHeader header;
+    if (llvm::sys::IsBigEndianHost || size < sizeof(header)) {
+        error = path + ": not a TCC shard / 不是 TCC 分片";
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, SHARD_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != SHARD_VERSION) {
+        error = path + ": not a TCC shard or unsupported version / 不是 TCC 分片或版本不受支持";
+        return false;
+    }
+    
+    uint64_t indexOffset = sizeof(ShardHeader);
+    uint64_t bytesOffset = indexOffset + uint64_t(header.stringCount) * sizeof(ShardString);
+    uint64_t recordsOffset = bytesOffset + alignTo8(header.stringBytes);
+    uint64_t end = recordsOffset + uint64_t(header.recordCount) * sizeof(ShardRecord);
+    if (header.stringBytes > size || end != size) {
+        error = path + ": truncated shard / 分片不完整";
+        return false;
+    }
+    
+    stringIndex_ = data + indexOffset;
+    stringBytes_ = data + bytesOffset;
+    records_ = data + recordsOffset;
+    stringCount_ = header.stringCount;
+    recordCount_ = header.recordCount;
+    buffer_ = std::move(*buffer);
+    
+    // Validate once so merging can trust every index / 一次性校验，归并时可信任所有索引
+    for (uint32_t i = 0; i < stringCount_; ++i) {
+        ShardString entry;
+        std::memcpy(&entry, stringIndex_ + i * sizeof(ShardString), sizeof(entry));
+        if (uint64_t(entry.offset) + entry.length > header.stringBytes) {
+            error = path + ": corrupt string table / 字符串表损坏";
+            return false;
+        }
+    }
+    for (size_t i = 0; i < recordCount_; ++i) {
+        ShardRecord record = getRecord(i);
+        bool valid = record.file < stringCount_ && record.ruleId < stringCount_ &&
+                     record.message < static_cast<uint16_t>(MessageId::Count) &&
+                     record.severity <= static_cast<uint8_t>(Severity::Note) &&
+                     record.category <= static_cast<uint8_t>(RuleCategory::TypeSafety) &&
+                     record.argumentCount <= Diagnostic::MAX_ARGUMENTS;
+        for (uint8_t a = 0; valid && a < record.argumentCount; ++a) {
+            valid = record.arguments[a] < stringCount_;
+        }
+        if (!valid) {
+            error = path + ": corrupt record / 记录损坏";
+            return false;
+        }
+    }
+    
+    interned_.assign(stringCount_, NOT_INTERNED);
+    return true;
+}
+
+ShardRecord ShardReader::getRecord(size_t index) const {
+    ShardRecord record;
+    std::memcpy(&record, records_ + index * sizeof(ShardRecord), sizeof(record));
+    return record;
+}
+
+std::string_view ShardReader::getString(uint32_t index) const {
+    ShardString entry;
+    std::memcpy(&entry, stringIndex_ + index * sizeof(ShardString), sizeof(entry));
+    return std::string_view(stringBytes_ + entry.offset, entry.length);
+}
+
+Diagnostic ShardReader::toDiagnostic(const ShardRecord& record) const {
+    auto intern = [&](uint32_t index) {
+        if (interned_[index] == NOT_INTERNED) {
+            interned_[index] = StringPool::global().intern(getString(index));
+        }
+        return interned_[index];
+    };
+    
+    StringId arguments[Diagnostic::MAX_ARGUMENTS] = {};
+    for (uint8_t i = 0; i < record.argumentCount; ++i) {
+        arguments[i] = intern(record.arguments[i]);
+    }
+    return Diagnostic(static_cast<Severity>(record.severity),
+                      static_cast<MessageId>(record.message),
+                      SourceLocation(intern(record.file), record.line, record.column),
+                      static_cast<RuleCategory>(record.category),
+                      intern(record.ruleId),
+                      arguments,
+                      record.argumentCount);
+}
+
+int compareShardRecords(const ShardReader& a, const ShardRecord& left,
+                        const ShardReader& b, const ShardRecord& right) {
+    return compareRecords(left, [&](uint32_t index) { return a.getString(index); },
+                          right, [&](uint32_t index) { return b.getString(index); });
+}
+
+size_t mergeShards(const std::vector<ShardReader>& shards, DiagnosticSink& sink) {
+    // Head record of each shard still being merged / 每个仍在归并的分片的首条记录
+    struct Cursor {
+        size_t shard;
+        size_t position;
+        ShardRecord record;
+    };
+    auto after = [&](const Cursor& a, const Cursor& b) {
+        return compareShardRecords(shards[a.shard], a.record, shards[b.shard], b.record) > 0;
+    };
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(after)> heap(after);
+    for (size_t i = 0; i < shards.size(); ++i) {
+        if (shards[i].size() > 0) {
+            heap.push({i, 0, shards[i].getRecord(0)});
+        }
+    }
+    
+    size_t written = 0;
+    bool hasLast = false;
+    Cursor last = {};
+    while (!heap.empty()) {
+        Cursor cursor = heap.top();
+        heap.pop();
+        
+        // Equal records are adjacent in merge order / 相同记录在归并顺序中相邻
+        if (!hasLast || compareShardRecords(shards[last.shard], last.record,
+                                            shards[cursor.shard], cursor.record) != 0) {
+            sink.handle(shards[cursor.shard].toDiagnostic(cursor.record));
+            ++written;
+            last = cursor;
+            hasLast = true;
+        }
+        
+        if (++cursor.position < shards[cursor.shard].size()) {
+            cursor.record = shards[cursor.shard].getRecord(cursor.position);
+            heap.push(cursor);
+        }
+    }
+    sink.finish();
+    return written;
+}
+
+} // namespace tcc
@@ -0,0 +1,376 @@
+﻿// Tough C Profiler - Shared Precompiled Headers Implementation
+// Tough C 分析器 - 共享预编译头实现
+
+#include "tcc/SharedPCH.h"
+
+#include <clang/Basic/Diagnostic.h>
+#include <clang/Basic/Version.h>
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/FrontendActions.h>
+#include <clang/Frontend/Utils.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/Path.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+namespace tcc {
+
+namespace {
+
+// Every file read, system headers included / 读取的所有文件，包括系统头文件
+class AllDependencyCollector : public clang::DependencyCollector {
+public:
+    bool needSystemDependencies() override { return true; }
+};
+
+// GeneratePCHAction writing to a fixed path and listing the files it read
+// 写入固定路径并列出所读文件的 GeneratePCHAction
+class BuildPCHAction : public clang::GeneratePCHAction {
+public:
+    BuildPCHAction(std::string outputPath, std::vector<std::string>& dependencies)
+        : outputPath_(std::move(outputPath)), dependencies_(dependencies) {}
+
+protected:
+    bool BeginInvocation(clang::CompilerInstance& ci) override {
+        ci.getFrontendOpts().OutputFile = outputPath_;
+        collector_ = std::make_shared<AllDependencyCollector>();
+        ci.addDependencyCollector(collector_);
+        return clang::GeneratePCHAction::BeginInvocation(ci);
+    }
+    
+    void EndSourceFileAction() override {
+        clang::GeneratePCHAction::EndSourceFileAction();
+        auto files = collector_->getDependencies();
+        dependencies_.assign(files.begin(), files.end());
+    }
+
+private:
+    std::string outputPath_;
+    std::vector<std::string>& dependencies_;
+    std::shared_ptr<AllDependencyCollector> collector_;
+};
+
+class BuildPCHActionFactory : public clang::tooling::FrontendActionFactory {
+public:
+    BuildPCHActionFactory(std::string outputPath, std::vector<std::string>& dependencies)
+        : outputPath_(std::move(outputPath)), dependencies_(dependencies) {}
+    
+    std::unique_ptr<clang::FrontendAction> create() override {
+        return std::make_unique<BuildPCHAction>(outputPath_, dependencies_);
+    }
+
+private:
+    std::string outputPath_;
+    std::vector<std::string>& dependencies_;
+};
+
+bool isCSource(const std::string& file) {
+    return llvm::sys::path::extension(file) == ".c";
+}
+
+// Compile command minus the input, outputs and dependency files, which
+// differ per TU without affecting the PCH
+// 去掉输入、输出和依赖文件的编译命令；这些因翻译单元而异但不影响 PCH
+std::vector<std::string> getSharedArguments(const clang::tooling::CompileCommand& command,
+                                            const std::string& file) {
+    std::vector<std::string> args;
+    const auto& commandLine = command.CommandLine;
+    for (size_t i = 1; i < commandLine.size(); ++i) {
+        const auto& arg = commandLine[i];
+        if (arg == command.Filename || arg == file || arg == "-c" ||
+            arg == "-MD" || arg == "-MMD") {
+            continue;
+        }
+        if (arg == "-o" || arg == "-MF" || arg == "-MT" || arg == "-MQ") {
+            ++i;
+            continue;
+        }
+        args.push_back(arg);
+    }
+    return args;
+}
+
+// Write via a temp file so concurrent runs never see a partial file
+// 通过临时文件写入，并发运行不会看到半写文件
+bool writeFileAtomically(const std::string& path, const std::string& content) {
+    int fd = -1;
+    llvm::SmallString<256> tempPath;
+    if (llvm::sys::fs::createUniqueFile(path + "-%%%%%%%%.tmp", fd, tempPath)) {
+        return false;
+    }
+    
+    {
+        llvm::raw_fd_ostream file(fd, /*shouldClose=*/true);
+        file << content;
+        file.close();
+        if (file.has_error()) {
+            file.clear_error();
+            llvm::sys::fs::remove(tempPath);
+            return false;
+        }
+    }
+    
+    if (llvm::sys::fs::rename(tempPath, path)) {
+        llvm::sys::fs::remove(tempPath);
+        return false;
+    }
+    return true;
+}
+
+// "<size> <mtime>" of a file, empty if it cannot be read
+// 文件的 "<大小> <修改时间>"，无法读取时为空
+std::string getFileStamp(const std::string& path) {
+    llvm::sys::fs::file_status status;
+    if (llvm::sys::fs::status(path, status)) {
+        return std::string();
+    }
+    auto modified = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        status.getLastModificationTime().time_since_epoch());
+    return std::to_string(status.getSize()) + " " + std::to_string(modified.count());
+}
+
+// Every file in a stamp file is unchanged / 戳文件中的每个文件都未改变
+// Lines are "<size> <mtime> <path>" / 每行为 "<大小> <修改时间> <路径>"
+bool isStampCurrent(const std::string& stampPath) {
+    std::ifstream input(stampPath);
+    std::string line;
+    bool any = false;
+    while (std::getline(input, line)) {
+        size_t pathStart = line.find(' ', line.find(' ') + 1);
+        if (pathStart == std::string::npos ||
+            getFileStamp(line.substr(pathStart + 1)) != line.substr(0, pathStart)) {
+            return false;
+        }
+        any = true;
+    }
+    return any;
+}
+
+std::string trimLeft(const std::string& text, size_t pos = 0) {
+    size_t start = text.find_first_not_of(" \t\r", pos);
+    return start == std::string::npos ? std::string() : text.substr(start);
+}
+
+// Blank or a trailing line comment / 空白或行尾注释
+bool isBlankOrComment(const std::string& text) {
+    std::string rest = trimLeft(text);
+    return rest.empty() || rest.compare(0, 2, "//") == 0;
+}
+
+} // namespace
+
+SharedPCH::SharedPCH(const clang::tooling::CompilationDatabase& compilations,
+                     std::string directory)
+    : compilations_(compilations)
+    , directory_(std::move(directory)) {
+    llvm::SmallString<256> pchDirectory(directory_);
+    llvm::sys::path::append(pchDirectory, "pch");
+    directory_ = pchDirectory.str().str();
+    llvm::sys::fs::create_directories(directory_);
+}
+
+std::vector<std::string> SharedPCH::scanIncludePrefix(const std::string& file) {
+    std::vector<std::string> prefix;
+    std::ifstream input(file);
+    if (!input.is_open()) {
+        return prefix;
+    }
+    
+    std::string line;
+    bool firstLine = true;
+    bool inBlockComment = false;
+    while (std::getline(input, line)) {
+        if (firstLine && line.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+            line.erase(0, 3);
+        }
+        firstLine = false;
+        
+        if (inBlockComment) {
+            size_t end = line.find("*/");
+            if (end == std::string::npos) {
+                continue;
+            }
+            inBlockComment = false;
+            line = line.substr(end + 2);
+        }
+        
+        std::string text = trimLeft(line);
+        if (text.compare(0, 2, "/*") == 0) {
+            size_t end = text.find("*/", 2);
+            if (end == std::string::npos) {
+                inBlockComment = true;
+                continue;
+            }
+            text = trimLeft(text, end + 2);
+        }
+        if (isBlankOrComment(text)) {
+            continue;
+        }
+        
+        // Only `#include <...>` and `#pragma once` extend the prefix; any other
+        // directive or code could change how later headers expand
+        // 只有 `#include <...>` 和 `#pragma once` 延续前缀；其他指令或代码
+        // 可能改变后续头文件的展开方式
+        if (text[0] != '#') {
+            break;
+        }
+        std::string directive = trimLeft(text, 1);
+        if (directive.compare(0, 6, "pragma") == 0 &&
+            trimLeft(directive, 6).compare(0, 4, "once") == 0) {
+            continue;
+        }
+        if (directive.compare(0, 7, "include") != 0) {
+            break;
+        }
+        
+        std::string target = trimLeft(directive, 7);
+        size_t close = target.find('>');
+        if (target.empty() || target[0] != '<' || close == std::string::npos ||
+            !isBlankOrComment(target.substr(close + 1))) {
+            break;
+        }
+        prefix.push_back(target.substr(0, close + 1));
+    }
+    return prefix;
+}
+
+std::string SharedPCH::getFlagSetKey(const std::string& file) const {
+    auto commands = compilations_.getCompileCommands(file);
+    if (commands.empty()) {
+        return std::string();
+    }
+    
+    const auto& command = commands.front();
+    std::string key = isCSource(file) ? "c" : "c++";
+    key += '\0';
+    key += command.Directory;
+    for (const auto& arg : getSharedArguments(command, file)) {
+        key += '\0';
+        key += arg;
+    }
+    return key;
+}
+
+void SharedPCH::prepare(const std::vector<std::string>& files, bool verbose,
+                        llvm::raw_ostream& log) {
+    // Group files by flag set / 按标志集分组
+    std::map<std::string, std::vector<std::string>> groups;
+    for (const auto& file : files) {
+        std::string key = getFlagSetKey(file);
+        if (!key.empty()) {
+            groups[key].push_back(file);
+        }
+    }
+    
+    for (const auto& group : groups) {
+        const auto& groupFiles = group.second;
+        
+        // Longest common include prefix / 最长公共包含前缀
+        auto prefix = scanIncludePrefix(groupFiles.front());
+        for (size_t i = 1; i < groupFiles.size() && !prefix.empty(); ++i) {
+            auto other = scanIncludePrefix(groupFiles[i]);
+            auto mismatch = std::mismatch(prefix.begin(), prefix.end(),
+                                          other.begin(), other.end());
+            prefix.erase(mismatch.first, prefix.end());
+        }
+        if (prefix.empty()) {
+            continue;
+        }
+        
+        llvm::MD5 hash;
+        hash.update(VERSION);
+        hash.update(clang::getClangFullVersion());
+        hash.update(group.first);
+        for (const auto& header : prefix) {
+            hash.update(header);
+            hash.update("\n");
+        }
+        llvm::MD5::MD5Result result;
+        hash.final(result);
+        
+        std::string base = directory_ + "/" + result.digest().str().str();
+        std::string headerPath = base + (isCSource(groupFiles.front()) ? ".h" : ".hpp");
+        std::string pchPath = base + ".pch";
+        std::string stampPath = base + ".stamp";
+        
+        // An edited system or SDK header makes the PCH unloadable, so it is
+        // rebuilt rather than failing every TU of the group
+        // 被修改的系统或 SDK 头文件会使 PCH 无法加载，因此重新构建它，而不是让组内每个翻译单元失败
+        if (llvm::sys::fs::exists(pchPath) && llvm::sys::fs::exists(headerPath) &&
+            isStampCurrent(stampPath)) {
+            if (verbose) {
+                log << "Reusing shared PCH / 复用共享 PCH: " << pchPath << "\n";
+            }
+        } else if (build(groupFiles.front(), prefix, headerPath, pchPath, stampPath)) {
+            if (verbose) {
+                log << "Built shared PCH of " << prefix.size() << " headers for "
+                    << groupFiles.size() << " files: " << pchPath << "\n";
+                log << "已为 " << groupFiles.size() << " 个文件构建包含 "
+                    << prefix.size() << " 个头文件的共享 PCH\n";
+            }
+        } else {
+            if (verbose) {
+                log << "Shared PCH build failed, parsing headers per file\n";
+                log << "共享 PCH 构建失败，逐文件解析头文件\n";
+            }
+            continue;
+        }
+        
+        for (const auto& file : groupFiles) {
+            pchByFile_[file] = pchPath;
+        }
+    }
+}
+
+std::string SharedPCH::getPCHFor(const std::string& file) const {
+    auto it = pchByFile_.find(file);
+    return it == pchByFile_.end() ? std::string() : it->second;
+}
+
+bool SharedPCH::build(const std::string& sampleFile, const std::vector<std::string>& prefix,
+                      const std::string& headerPath, const std::string& pchPath,
+                      const std::string& stampPath) {
+    std::string header = "// Generated by tcc-check / 由 tcc-check 生成\n";
+    for (const auto& include : prefix) {
+        header += "#include " + include + "\n";
+    }
+    if (!writeFileAtomically(headerPath, header)) {
+        return false;
+    }
+    
+    // Same flags as the group, with the prefix header as input
+    // 与组内相同的标志，以前缀头作为输入
+    auto command = compilations_.getCompileCommands(sampleFile).front();
+    clang::tooling::FixedCompilationDatabase database(
+        command.Directory, getSharedArguments(command, sampleFile));
+    
+    clang::tooling::ClangTool tool(database, {headerPath});
+    clang::IgnoringDiagConsumer ignoreDiagnostics;
+    tool.setDiagnosticConsumer(&ignoreDiagnostics);
+    std::vector<std::string> dependencies;
+    BuildPCHActionFactory factory(pchPath, dependencies);
+    if (tool.run(&factory) != 0 || !llvm::sys::fs::exists(pchPath)) {
+        return false;
+    }
+    
+    // Written last, so a PCH without a current stamp is never reused
+    // 最后写入，因此没有最新戳的 PCH 永远不会被复用
+    std::string stamps;
+    for (const auto& dependency : dependencies) {
+        llvm::SmallString<256> path(dependency);
+        llvm::sys::fs::make_absolute(command.Directory, path);
+        std::string stamp = getFileStamp(path.str().str());
+        if (stamp.empty()) {
+            return false;
+        }
+        stamps += stamp + " " + path.str().str() + "\n";
+    }
+    return !stamps.empty() && writeFileAtomically(stampPath, stamps);
+}
+
+} // namespace tcc
@@ -0,0 +1,59 @@
+﻿// Tough C Profiler - Source Location Resolution Implementation
+// Tough C 分析器 - 源码位置解析实现
+
+#include "tcc/SourceManagerResolver.h"
+
+namespace tcc {
+
+namespace {
+
+SourceLocation fromPresumed(const clang::PresumedLoc& presumed) {
+    if (presumed.isInvalid()) {
+        return SourceLocation();
+    }
+    return SourceLocation(presumed.getFilename(), presumed.getLine(), presumed.getColumn());
+}
+
+} // namespace
+
+SourceLocation SourceManagerResolver::resolve(uint32_t rawLocation) {
+    auto loc = clang::SourceLocation::getFromRawEncoding(rawLocation);
+    if (loc.isInvalid()) {
+        return SourceLocation();
+    }
+    
+    auto decomposed = sm_.getDecomposedExpansionLoc(loc);
+    auto found = files_.find(decomposed.first);
+    if (found == files_.end()) {
+        // First location in this file: one full lookup, cached by FileID
+        // 此文件中的第一个位置：完整查找一次，按 FileID 缓存
+        auto presumed = sm_.getPresumedLoc(loc);
+        if (presumed.isInvalid()) {
+            return SourceLocation();
+        }
+        bool invalid = false;
+        const auto& entry = sm_.getSLocEntry(decomposed.first, &invalid);
+        bool lineDirectives = invalid || !entry.isFile() || entry.getFile().hasLineDirectives();
+        files_.try_emplace(decomposed.first,
+                           FileInfo{StringPool::global().intern(presumed.getFilename()),
+                                    lineDirectives});
+        return fromPresumed(presumed);
+    }
+    
+    if (found->second.lineDirectives) {
+        return fromPresumed(sm_.getPresumedLoc(loc));
+    }
+    return SourceLocation(found->second.name,
+                          sm_.getLineNumber(decomposed.first, decomposed.second),
+                          sm_.getColumnNumber(decomposed.first, decomposed.second));
+}
+
+uint32_t SourceManagerResolver::getSpelling(uint32_t rawLocation) {
+    auto loc = clang::SourceLocation::getFromRawEncoding(rawLocation);
+    if (!loc.isMacroID()) {
+        return rawLocation;
+    }
+    return sm_.getSpellingLoc(loc).getRawEncoding();
+}
+
+} // namespace tcc
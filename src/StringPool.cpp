@@ -0,0 +1,45 @@
+﻿// Tough C Profiler - String Pool Implementation
+// Tough C 分析器 - 字符串池实现
+
+#include "tcc/StringPool.h"
+
+namespace tcc {
+
+StringPool& StringPool::global() {
+    static StringPool pool;
+    return pool;
+}
+
+StringId StringPool::intern(std::string_view value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = ids_.find(value);
+    if (it != ids_.end()) {
+        return it->second;
+    }
+    
+    // Keys view the deque's copy, which never moves / 键引用 deque 中的副本，其地址不会移动
+    auto id = static_cast<StringId>(strings_.size());
+    strings_.emplace_back(value);
+    ids_.emplace(strings_.back(), id);
+    return id;
+}
+
+const std::string& StringPool::get(StringId id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return strings_[id];
+}
+
+size_t StringPool::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return strings_.size();
+}
+
+void StringPool::truncate(size_t mark) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (strings_.size() > mark) {
+        ids_.erase(strings_.back());
+        strings_.pop_back();
+    }
+}
+
+} // namespace tcc
@@ -0,0 +1,140 @@
+﻿// Tough C Profiler - Time Report Implementation
+// Tough C 分析器 - 时间报告实现
+
+#include "tcc/TimeReport.h"
+
+#include <llvm/Support/Format.h>
+#include <llvm/Support/JSON.h>
+
+#include <algorithm>
+#include <ctime>
+
+namespace tcc {
+
+Stopwatch::Stopwatch()
+    : wallStart_(std::chrono::steady_clock::now())
+    , cpuStart_(threadCpuSeconds()) {}
+
+double Stopwatch::wallSeconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart_).count();
+}
+
+double Stopwatch::cpuSeconds() const {
+    return threadCpuSeconds() - cpuStart_;
+}
+
+double Stopwatch::threadCpuSeconds() {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec now;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) == 0) {
+        return static_cast<double>(now.tv_sec) + static_cast<double>(now.tv_nsec) * 1e-9;
+    }
+#endif
+    // Process-wide fallback / 进程级回退
+    return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+}
+
+void RuleStats::add(const RuleStats& other) {
+    wallSeconds += other.wallSeconds;
+    cpuSeconds += other.cpuSeconds;
+    nodes += other.nodes;
+    runs += other.runs;
+    diagnostics += other.diagnostics;
+}
+
+void TimeReport::addPhase(const std::string& phase, double wallSeconds, double cpuSeconds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(phases_.begin(), phases_.end(),
+                           [&](const auto& entry) { return entry.first == phase; });
+    if (it == phases_.end()) {
+        phases_.emplace_back(phase, PhaseStats());
+        it = phases_.end() - 1;
+    }
+    it->second.wallSeconds += wallSeconds;
+    it->second.cpuSeconds += cpuSeconds;
+    ++it->second.count;
+}
+
+void TimeReport::addPhase(const std::string& phase, const Stopwatch& stopwatch) {
+    addPhase(phase, stopwatch.wallSeconds(), stopwatch.cpuSeconds());
+}
+
+void TimeReport::addRule(const std::string& ruleId, const RuleStats& stats) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rules_[ruleId].add(stats);
+}
+
+void TimeReport::setElapsed(double wallSeconds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    elapsedSeconds_ = wallSeconds;
+}
+
+void TimeReport::printTable(llvm::raw_ostream& os) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    os << "\n=== Time report / 时间报告 ===\n";
+    os << llvm::format("Elapsed / 总耗时: %.3f s\n\n", elapsedSeconds_);
+    
+    os << llvm::left_justify("Phase", 24) << llvm::right_justify("Wall(s)", 11)
+       << llvm::right_justify("CPU(s)", 11) << llvm::right_justify("Count", 9) << "\n";
+    for (const auto& entry : phases_) {
+        const auto& stats = entry.second;
+        os << llvm::left_justify(entry.first, 24)
+           << llvm::format("%11.3f%11.3f%9llu\n", stats.wallSeconds, stats.cpuSeconds,
+                           static_cast<unsigned long long>(stats.count));
+    }
+    
+    // Most expensive rules first / 开销最大的规则优先
+    std::vector<std::pair<std::string, RuleStats>> rules(rules_.begin(), rules_.end());
+    std::stable_sort(rules.begin(), rules.end(), [](const auto& a, const auto& b) {
+        return a.second.cpuSeconds > b.second.cpuSeconds;
+    });
+    
+    os << "\n";
+    os << llvm::left_justify("Rule", 24) << llvm::right_justify("Wall(s)", 11)
+       << llvm::right_justify("CPU(s)", 11) << llvm::right_justify("Nodes", 11)
+       << llvm::right_justify("Runs", 7) << llvm::right_justify("Diags", 9) << "\n";
+    for (const auto& entry : rules) {
+        const auto& stats = entry.second;
+        os << llvm::left_justify(entry.first, 24)
+           << llvm::format("%11.4f%11.4f%11llu%7llu%9llu\n", stats.wallSeconds, stats.cpuSeconds,
+                           static_cast<unsigned long long>(stats.nodes),
+                           static_cast<unsigned long long>(stats.runs),
+                           static_cast<unsigned long long>(stats.diagnostics));
+    }
+}
+
+void TimeReport::printJSON(llvm::raw_ostream& os) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    llvm::json::OStream json(os, 2);
+    json.object([&] {
+        json.attribute("version", VERSION);
+        json.attribute("elapsedSeconds", elapsedSeconds_);
+        json.attributeArray("phases", [&] {
+            for (const auto& entry : phases_) {
+                json.object([&] {
+                    json.attribute("name", entry.first);
+                    json.attribute("wallSeconds", entry.second.wallSeconds);
+                    json.attribute("cpuSeconds", entry.second.cpuSeconds);
+                    json.attribute("count", static_cast<int64_t>(entry.second.count));
+                });
+            }
+        });
+        json.attributeArray("rules", [&] {
+            for (const auto& entry : rules_) {
+                json.object([&] {
+                    json.attribute("id", entry.first);
+                    json.attribute("wallSeconds", entry.second.wallSeconds);
+                    json.attribute("cpuSeconds", entry.second.cpuSeconds);
+                    json.attribute("nodes", static_cast<int64_t>(entry.second.nodes));
+                    json.attribute("runs", static_cast<int64_t>(entry.second.runs));
+                    json.attribute("diagnostics", static_cast<int64_t>(entry.second.diagnostics));
+                });
+            }
+        });
+    });
+    os << "\n";
+}
+
+} // namespace tcc
@@ -0,0 +1,60 @@
+﻿// Tough C Profiler - Type Classifier Implementation
+// Tough C 分析器 - 类型分类器实现
+
+#include "tcc/TypeClassifier.h"
+
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/DeclTemplate.h>
+#include <llvm/ADT/StringSwitch.h>
+
+namespace tcc {
+
+TypeClass TypeClassifier::classify(clang::QualType type) {
+    if (type.isNull()) {
+        return TypeClass::Other;
+    }
+    
+    const auto* record = type->getAsCXXRecordDecl();
+    if (!record) {
+        return TypeClass::Other;
+    }
+    
+    // Specializations share their template's entry / 特化共享其模板的条目
+    const clang::Decl* key = record->getCanonicalDecl();
+    if (const auto* spec = llvm::dyn_cast<clang::ClassTemplateSpecializationDecl>(record)) {
+        key = spec->getSpecializedTemplate()->getCanonicalDecl();
+    }
+    
+    auto inserted = cache_.try_emplace(key, TypeClass::Other);
+    if (inserted.second) {
+        inserted.first->second = classifyRecord(*record);
+    }
+    return inserted.first->second;
+}
+
+TypeClass TypeClassifier::classifyRecord(const clang::CXXRecordDecl& record) {
+    // Looks through inline namespaces such as std::__1 and std::__cxx11
+    // 穿透 std::__1、std::__cxx11 等内联命名空间
+    const clang::IdentifierInfo* name = record.getIdentifier();
+    if (!name || !record.isInStdNamespace()) {
+        return TypeClass::Other;
+    }
+    
+    return llvm::StringSwitch<TypeClass>(name->getName())
+        .Cases("unique_ptr", "shared_ptr", "weak_ptr", "auto_ptr", TypeClass::SmartPointer)
+        .Cases("vector", "deque", "list", "forward_list", "array", TypeClass::Container)
+        .Cases("set", "multiset", "unordered_set", "unordered_multiset", TypeClass::Container)
+        .Cases("map", "multimap", "unordered_map", "unordered_multimap", TypeClass::Map)
+        .Case("basic_string", TypeClass::String)
+        .Cases("basic_string_view", "span", TypeClass::View)
+        .Cases("atomic", "atomic_ref", "atomic_flag", TypeClass::Atomic)
+        .Cases("mutex", "recursive_mutex", "timed_mutex", "recursive_timed_mutex",
+               TypeClass::Mutex)
+        .Cases("shared_mutex", "shared_timed_mutex", TypeClass::Mutex)
+        .Cases("lock_guard", "unique_lock", "scoped_lock", "shared_lock", TypeClass::Lock)
+        .Cases("condition_variable", "condition_variable_any", "once_flag", TypeClass::SyncPrimitive)
+        .Cases("counting_semaphore", "latch", "barrier", TypeClass::SyncPrimitive)
+        .Default(TypeClass::Other);
+}
+
+} // namespace tcc
@@ -0,0 +1,205 @@
+﻿// Tough C Profiler - Watch Mode Implementation
+// Tough C 分析器 - 监视模式实现
+
+#include "tcc/Watcher.h"
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace tcc {
+
+#ifdef __linux__
+
+namespace {
+
+// Quiet period that ends a burst of editor writes / 结束一批编辑器写入的静默期
+constexpr int DEBOUNCE_MS = 100;
+
+constexpr uint32_t WATCH_EVENTS =
+    IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE;
+
+// Read pending events and add the touched paths / 读取待处理事件并加入被触及的路径
+bool readEvents(int fd, const std::map<int, std::string>& directoryOf,
+                std::set<std::string>& changed) {
+    alignas(inotify_event) char buffer[16 * 1024];
+    ssize_t length = ::read(fd, buffer, sizeof(buffer));
+    if (length < 0) {
+        return errno == EINTR || errno == EAGAIN;
+    }
+    
+    for (char* ptr = buffer; ptr < buffer + length;) {
+        auto* event = reinterpret_cast<inotify_event*>(ptr);
+        auto it = directoryOf.find(event->wd);
+        if (it != directoryOf.end() && event->len > 0) {
+            changed.insert(it->second + "/" + event->name);
+        }
+        ptr += sizeof(inotify_event) + event->len;
+    }
+    return true;
+}
+
+} // namespace
+
+Watcher::Watcher(Driver& driver, const clang::tooling::CompilationDatabase& compilations,
+                 llvm::raw_ostream& log)
+    : driver_(driver)
+    , compilations_(compilations)
+    , log_(log) {}
+
+int Watcher::run(const std::vector<std::string>& files, const ReportFn& report) {
+    results_ = driver_.run(files);
+    filesOf_.assign(results_.size(), {});
+    for (size_t tu = 0; tu < results_.size(); ++tu) {
+        index(tu);
+    }
+    report(results_);
+    
+    int fd = ::inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (fd < 0) {
+        log_ << "inotify_init1 failed: " << std::strerror(errno) << "\n";
+        return static_cast<int>(ExitCode::InternalError);
+    }
+    
+    std::map<int, std::string> directoryOf;
+    std::set<std::string> watched;
+    bool announce = true;
+    for (;;) {
+        // Directories of newly discovered dependencies / 新发现依赖所在的目录
+        for (const auto& directory : directories_) {
+            if (watched.insert(directory).second) {
+                int wd = ::inotify_add_watch(fd, directory.c_str(), WATCH_EVENTS);
+                if (wd >= 0) {
+                    directoryOf[wd] = directory;
+                }
+            }
+        }
+        
+        if (announce) {
+            log_ << "\nWatching " << results_.size() << " files, Ctrl-C to stop\n";
+            log_ << "正在监视 " << results_.size() << " 个文件，按 Ctrl-C 停止\n";
+            log_.flush();
+            announce = false;
+        }
+        
+        // Block for the first event, then collect until quiet
+        // 阻塞等待第一个事件，然后持续收集直到静默
+        std::set<std::string> changed;
+        pollfd waitFd{fd, POLLIN, 0};
+        int timeout = -1;
+        for (;;) {
+            int ready = ::poll(&waitFd, 1, timeout);
+            if (ready < 0 && errno != EINTR) {
+                log_ << "poll failed: " << std::strerror(errno) << "\n";
+                ::close(fd);
+                return static_cast<int>(ExitCode::InternalError);
+            }
+            if (ready == 0) {
+                break;
+            }
+            if (ready > 0 && !readEvents(fd, directoryOf, changed)) {
+                log_ << "inotify read failed: " << std::strerror(errno) << "\n";
+                ::close(fd);
+                return static_cast<int>(ExitCode::InternalError);
+            }
+            timeout = DEBOUNCE_MS;
+        }
+        
+        // Affected TUs from the reverse include graph / 从反向包含图得到受影响的翻译单元
+        std::set<size_t> affected;
+        for (const auto& path : changed) {
+            auto it = dependents_.find(path);
+            if (it != dependents_.end()) {
+                affected.insert(it->second.begin(), it->second.end());
+            }
+        }
+        if (affected.empty()) {
+            continue;
+        }
+        
+        std::vector<size_t> indices(affected.begin(), affected.end());
+        std::vector<std::string> subset;
+        for (size_t tu : indices) {
+            subset.push_back(results_[tu].file);
+        }
+        
+        log_ << "\nRe-checking " << subset.size() << " of " << results_.size() << " files\n";
+        log_ << "重新检查 " << subset.size() << " / " << results_.size() << " 个文件\n";
+        
+        // Unaffected TUs keep their results / 未受影响的翻译单元保留结果
+        auto fresh = driver_.run(subset);
+        for (size_t k = 0; k < indices.size(); ++k) {
+            results_[indices[k]] = std::move(fresh[k]);
+            index(indices[k]);
+        }
+        report(results_);
+        announce = true;
+    }
+}
+
+void Watcher::index(size_t tu) {
+    for (const auto& path : filesOf_[tu]) {
+        dependents_[path].erase(tu);
+    }
+    filesOf_[tu].clear();
+    
+    const auto& result = results_[tu];
+    auto commands = compilations_.getCompileCommands(result.file);
+    std::string directory = commands.empty() ? std::string() : commands.front().Directory;
+    
+    // The main file always counts, so adding @tcc to a skipped file is seen
+    // 主文件始终计入，因此给被跳过的文件加上 @tcc 也能被察觉
+    std::vector<std::string> files = result.dependencies;
+    files.push_back(result.file);
+    for (const auto& file : files) {
+        std::string path = canonicalize(file, directory);
+        filesOf_[tu].insert(path);
+        dependents_[path].insert(tu);
+        directories_.insert(llvm::sys::path::parent_path(path).str());
+    }
+}
+
+std::string Watcher::canonicalize(const std::string& path, const std::string& directory) {
+    llvm::SmallString<256> absolute(path);
+    if (!llvm::sys::path::is_absolute(absolute)) {
+        absolute = directory;
+        llvm::sys::path::append(absolute, path);
+    }
+    llvm::sys::fs::make_absolute(absolute);
+    llvm::sys::path::remove_dots(absolute, /*remove_dot_dot=*/true);
+    
+    // Watched directories are real paths, so match files against them too
+    // 被监视的目录是真实路径，因此文件也按真实路径匹配
+    llvm::SmallString<256> real;
+    if (!llvm::sys::fs::real_path(absolute, real)) {
+        return real.str().str();
+    }
+    return absolute.str().str();
+}
+
+#else
+
+Watcher::Watcher(Driver& driver, const clang::tooling::CompilationDatabase& compilations,
+                 llvm::raw_ostream& log)
+    : driver_(driver)
+    , compilations_(compilations)
+    , log_(log) {}
+
+int Watcher::run(const std::vector<std::string>&, const ReportFn&) {
+    log_ << "--watch requires inotify (Linux)\n";
+    log_ << "--watch 需要 inotify（Linux）\n";
+    return static_cast<int>(ExitCode::InvalidArguments);
+}
+
+#endif
+
+} // namespace tcc
@@ -0,0 +1,17 @@
+﻿// Test file for type classification: only std types are exempt
+// 类型分类测试文件：只有 std 类型被豁免
+// @tcc
+
+#include <atomic>
+#include <mutex>
+
+// A user type whose name merely contains "atomic" / 名称仅包含 "atomic" 的用户类型
+struct my_atomic_log {
+    int entries = 0;
+};
+
+my_atomic_log audit_log;  // TCC-CONC-001 warning
+
+// GOOD: standard synchronization types / 良好：标准同步类型
+std::atomic<int> hits{0};
+std::mutex hits_mutex;
@@ -0,0 +1,19 @@
+﻿// Test file for gate mode - cheap and expensive violations together
+// 门禁模式测试文件 - 廉价和昂贵的违规同时存在
+// @tcc
+
+// BAD: Raw allocation, found by a cheap rule / 错误：原始分配，由廉价规则发现
+int* getCounter() {
+    return new int(0);  // TCC-OWN-001 error
+}
+
+// BAD: Recursion, found by the expensive test plugin rule
+// 错误：递归，由昂贵的测试插件规则发现
+int depth(int n) {  // TCC-TEST-002 warning, skipped by --gate
+    return n > 0 ? depth(n - 1) + 1 : 0;
+}
+
+int main() {
+    int* counter = getCounter();
+    return *counter + depth(3);
+}
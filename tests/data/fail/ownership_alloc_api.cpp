@@ -0,0 +1,24 @@
+﻿// Test file for the allocation API catalog
+// 分配 API 目录测试文件
+// @tcc
+
+#include <cstdlib>
+#include <cstring>
+
+// In-house allocator, declared here / 内部分配器，在此声明
+void* pool_alloc(size_t size);
+
+// BAD: built-in catalog entry / 错误：内置目录条目
+void* makeBuffer() {
+    return aligned_alloc(64, 256);  // TCC-OWN-003
+}
+
+// Forbidden by default, allowed by alloc_api.catalog / 默认禁止，alloc_api.catalog 允许
+char* copyName(const char* name) {
+    return strdup(name);
+}
+
+// Reported only with alloc_api.catalog / 仅在使用 alloc_api.catalog 时报告
+void* makeNode() {
+    return pool_alloc(32);
+}
@@ -0,0 +1,10 @@
+﻿// Test file for rules loaded from a plugin
+// 插件加载规则测试文件
+// @tcc
+
+#include <cstdlib>
+
+// Reported only with the test plugin loaded / 仅在加载测试插件时报告
+void shutdown(int status) {
+    std::exit(status);  // TCC-TEST-001 warning
+}
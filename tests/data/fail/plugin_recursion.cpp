@@ -0,0 +1,18 @@
+﻿// Test file for the expensive plugin rule - recursion through two functions
+// 昂贵插件规则测试文件 - 经由两个函数的递归
+// @tcc
+
+bool isOdd(unsigned n);
+
+// BAD: Mutual recursion / 错误：相互递归
+bool isEven(unsigned n) {  // TCC-TEST-002 warning
+    return n == 0 || isOdd(n - 1);
+}
+
+bool isOdd(unsigned n) {  // TCC-TEST-002 warning
+    return n != 0 && isEven(n - 1);
+}
+
+int main() {
+    return isEven(4) ? 0 : 1;
+}
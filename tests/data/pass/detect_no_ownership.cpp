@@ -0,0 +1,12 @@
+﻿// Test file opting out of ownership checks
+// 退出所有权检查的测试文件
+// @tcc
+// @tcc-no-ownership
+
+int* makeValue() {
+    return new int(42);  // Ownership not checked / 不检查所有权
+}
+
+void releaseValue(int* value) {
+    delete value;  // Ownership not checked / 不检查所有权
+}
@@ -0,0 +1,10 @@
+﻿// Test file without TCC opt-in: skipped before parsing
+// 未启用 TCC 的测试文件：解析前即被跳过
+
+int* makeValue() {
+    return new int(42);  // Not checked / 不检查
+}
+
+void releaseValue(int* value) {
+    delete value;  // Not checked / 不检查
+}
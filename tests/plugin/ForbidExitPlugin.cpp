@@ -0,0 +1,41 @@
+﻿// Tough C Profiler - Test Rule Plugin
+// Tough C 分析器 - 测试规则插件
+//
+// Minimal plugin loaded by the tests with --load
+// 测试通过 --load 加载的最小插件
+
+#include "tcc/Rule.h"
+
+namespace {
+
+// Rule: Forbid exit() and quick_exit() while other threads may run
+// 规则：禁止在其他线程可能运行时调用 exit() 和 quick_exit()
+class ForbidExitRule
+    : public tcc::NodeRule<ForbidExitRule, tcc::ConcurrencyRule, tcc::NodeKind::CallExpr> {
+public:
+    ForbidExitRule()
+        : NodeRule("TCC-TEST-001",
+                  "Process exit from TCC code / 在 TCC 代码中退出进程") {}
+    
+    void checkCallExpr(clang::CallExpr* call, clang::ASTContext& context,
+                       tcc::DiagnosticEngine& diagnostics) {
+        const auto* callee = call->getDirectCallee();
+        if (!callee || !callee->getIdentifier()) {
+            return;
+        }
+        
+        llvm::StringRef name = callee->getName();
+        if (name == "exit" || name == "quick_exit") {
+            report(diagnostics, context, call->getBeginLoc(), tcc::Severity::Warning,
+                   tcc::MessageId::PluginRule,
+                   {"Process exit while other threads may run",
+                    "其他线程可能仍在运行时退出进程"});
+        }
+    }
+};
+
+tcc::RuleRegistry::Add<ForbidExitRule> forbidExit;
+
+} // namespace
+
+TCC_RULE_PLUGIN()
@@ -0,0 +1,84 @@
+﻿// Tough C Profiler - Expensive Test Rule Plugin
+// Tough C 分析器 - 昂贵测试规则插件
+//
+// Call-graph rule loaded by the cost tier tests with --load
+// 开销层级测试通过 --load 加载的调用图规则
+
+#include "tcc/Rule.h"
+
+#include <clang/AST/RecursiveASTVisitor.h>
+#include <llvm/ADT/SmallPtrSet.h>
+
+#include <vector>
+
+namespace {
+
+// Direct callees of one function body / 一个函数体的直接被调用者
+class CalleeCollector : public clang::RecursiveASTVisitor<CalleeCollector> {
+public:
+    explicit CalleeCollector(std::vector<const clang::FunctionDecl*>& callees)
+        : callees_(callees) {}
+    
+    bool VisitCallExpr(clang::CallExpr* call) {
+        if (const auto* callee = call->getDirectCallee()) {
+            callees_.push_back(callee);
+        }
+        return true;
+    }
+
+private:
+    std::vector<const clang::FunctionDecl*>& callees_;
+};
+
+// Rule: Forbid recursion, direct or through other functions of the TU
+// 规则：禁止递归，无论是直接递归还是经由翻译单元中其他函数的递归
+// Walks the call graph from every function definition, so it is the
+// expensive tier gate mode holds back.
+// 从每个函数定义出发遍历调用图，因此属于门禁模式推迟运行的昂贵层级。
+class ForbidRecursionRule
+    : public tcc::NodeRule<ForbidRecursionRule, tcc::LifetimeRule, tcc::NodeKind::FunctionDecl> {
+public:
+    ForbidRecursionRule()
+        : NodeRule("TCC-TEST-002",
+                  "Recursive call chain / 递归调用链",
+                  tcc::RuleCost::Expensive) {}
+    
+    void checkFunctionDecl(clang::FunctionDecl* function, clang::ASTContext& context,
+                           tcc::DiagnosticEngine& diagnostics) {
+        if (!function->doesThisDeclarationHaveABody()) {
+            return;
+        }
+        
+        const clang::FunctionDecl* self = function->getCanonicalDecl();
+        llvm::SmallPtrSet<const clang::FunctionDecl*, 32> visited;
+        std::vector<const clang::FunctionDecl*> pending = {function};
+        while (!pending.empty()) {
+            const clang::FunctionDecl* definition = nullptr;
+            if (!pending.back()->hasBody(definition) ||
+                !visited.insert(definition->getCanonicalDecl()).second) {
+                pending.pop_back();
+                continue;
+            }
+            pending.pop_back();
+            
+            std::vector<const clang::FunctionDecl*> callees;
+            CalleeCollector(callees).TraverseStmt(const_cast<clang::Stmt*>(definition->getBody()));
+            for (const auto* callee : callees) {
+                if (callee->getCanonicalDecl() == self) {
+                    report(diagnostics, context, function->getLocation(), tcc::Severity::Warning,
+                           tcc::MessageId::PluginRule,
+                           {"Recursive call chain; stack depth is unbounded",
+                            "递归调用链；栈深度没有上限"});
+                    return;
+                }
+                pending.push_back(callee);
+            }
+        }
+    }
+};
+
+tcc::RuleRegistry::Add<ForbidRecursionRule> forbidRecursion;
+
+} // namespace
+
+TCC_RULE_PLUGIN()
@@ -0,0 +1,37 @@
+﻿# Tough C Tests - Parallel Output Check
+# Tough C 测试 - 并行输出检查
+#
+# Runs tcc-check over every test file with -j 1 and -j 4 and fails unless
+# both runs print byte-identical output and return the same exit code
+# 以 -j 1 和 -j 4 对所有测试文件运行 tcc-check，两次输出逐字节相同且退出码相同才通过
+#
+# Usage / 用法: cmake -DTCC_CHECK=<path> -DTEST_DATA_DIR=<dir> -P CheckJobsIdentical.cmake
+
+file(GLOB_RECURSE inputs ${TEST_DATA_DIR}/*.cpp)
+list(SORT inputs)
+
+foreach(jobs 1 4)
+    execute_process(
+        COMMAND ${TCC_CHECK} -j ${jobs} ${inputs}
+        RESULT_VARIABLE result_${jobs}
+        OUTPUT_VARIABLE out_${jobs}
+        ERROR_VARIABLE err_${jobs}
+    )
+endforeach()
+
+# The inputs contain violations, so an empty report proves nothing
+# 输入包含违规，因此空报告证明不了任何事
+if(NOT result_1 EQUAL 1)
+    message(FATAL_ERROR "-j 1 exited with ${result_1}, expected 1 / -j 1 退出码为 ${result_1}，应为 1\n${err_1}")
+endif()
+if(NOT result_4 EQUAL result_1)
+    message(FATAL_ERROR "-j 4 exited with ${result_4}, -j 1 with ${result_1} / 退出码不同")
+endif()
+if(NOT out_4 STREQUAL out_1)
+    message(FATAL_ERROR "stdout differs between -j 1 and -j 4 / -j 1 与 -j 4 的标准输出不同\n"
+                        "-j 1:\n${out_1}\n-j 4:\n${out_4}")
+endif()
+if(NOT err_4 STREQUAL err_1)
+    message(FATAL_ERROR "stderr differs between -j 1 and -j 4 / -j 1 与 -j 4 的标准错误不同\n"
+                        "-j 1:\n${err_1}\n-j 4:\n${err_4}")
+endif()
@@ -0,0 +1,63 @@
+﻿# Tough C Tests - Result Cache Check
+# Tough C 测试 - 结果缓存检查
+#
+# A cold run stores an entry, a warm run replays the same diagnostics from it,
+# and a changed rule set or an edited file misses it
+# 冷运行存储条目，热运行从中回放相同的诊断，规则集改变或文件被编辑时不命中
+#
+# Usage / 用法: cmake -DTCC_CHECK=<path> -DTEST_DATA_DIR=<dir> -DWORK_DIR=<dir> -P CheckResultCache.cmake
+
+set(source ${WORK_DIR}/cached_tu.cpp)
+set(cache ${WORK_DIR}/cache)
+file(REMOVE_RECURSE ${WORK_DIR})
+configure_file(${TEST_DATA_DIR}/fail/ownership_new_delete.cpp ${source} COPYONLY)
+
+# "--" keeps the build tree's compile_commands.json out of the key
+# "--" 使构建树的 compile_commands.json 不进入缓存键
+function(run_check prefix)
+    execute_process(
+        COMMAND ${TCC_CHECK} --cache-dir=${cache} --verbose ${ARGN} ${source} --
+        RESULT_VARIABLE result
+        OUTPUT_VARIABLE out
+        ERROR_VARIABLE err
+    )
+    set(${prefix}_result "${result}" PARENT_SCOPE)
+    set(${prefix}_out "${out}" PARENT_SCOPE)
+    set(${prefix}_err "${err}" PARENT_SCOPE)
+endfunction()
+
+# Cold run: violations reported and an entry stored / 冷运行：报告违规并存储条目
+run_check(cold)
+if(NOT cold_result EQUAL 1 OR cold_out MATCHES "Cache hit")
+    message(FATAL_ERROR "Cold run / 冷运行 (${cold_result}):\n${cold_out}${cold_err}")
+endif()
+file(GLOB_RECURSE entries LIST_DIRECTORIES false ${cache}/*)
+if(NOT entries)
+    message(FATAL_ERROR "Cold run stored no cache entry / 冷运行未存储缓存条目")
+endif()
+
+# Warm run: the same diagnostics without parsing / 热运行：无需解析即得到相同的诊断
+run_check(warm)
+if(NOT warm_out MATCHES "Cache hit: [^\n]*cached_tu\\.cpp")
+    message(FATAL_ERROR "Warm run missed the cache / 热运行未命中缓存:\n${warm_out}")
+endif()
+if(NOT warm_result EQUAL cold_result OR NOT warm_err STREQUAL cold_err)
+    message(FATAL_ERROR "Warm run replayed different diagnostics / 热运行回放的诊断不同\n"
+                        "Cold / 冷:\n${cold_err}\nWarm / 热:\n${warm_err}")
+endif()
+
+# A different rule set needs its own entry / 不同的规则集需要自己的条目
+run_check(rules --no-lifetime)
+if(rules_out MATCHES "Cache hit")
+    message(FATAL_ERROR "--no-lifetime reused the full rule set's entry / --no-lifetime 复用了完整规则集的条目")
+endif()
+
+# An edited file is checked again and its new code reported / 被编辑的文件被重新检查并报告新代码
+file(APPEND ${source} "int* leak() { return new int(1); }\n")
+run_check(edited)
+if(edited_out MATCHES "Cache hit")
+    message(FATAL_ERROR "Edited file hit the cache / 被编辑的文件命中了缓存")
+endif()
+if(NOT edited_err MATCHES "cached_tu\\.cpp:28:[^\n]*\\[TCC-OWN-001\\]")
+    message(FATAL_ERROR "Edited file missed its new violation / 被编辑的文件缺少新违规:\n${edited_err}")
+endif()
@@ -0,0 +1,48 @@
+﻿# Tough C Tests - Shared PCH Check
+# Tough C 测试 - 共享 PCH 检查
+#
+# Two files sharing an include prefix get one PCH, a second run reuses it,
+# and editing the prefix header rebuilds it
+# 共享包含前缀的两个文件得到一个 PCH，第二次运行复用它，编辑前缀头文件会重建它
+#
+# Usage / 用法: cmake -DTCC_CHECK=<path> -DWORK_DIR=<dir> -P CheckSharedPCH.cmake
+
+set(include_dir ${WORK_DIR}/include)
+set(header ${include_dir}/tcc_prefix.h)
+file(REMOVE_RECURSE ${WORK_DIR})
+file(WRITE ${header} "#pragma once\ninline int prefixValue() { return 1; }\n")
+file(WRITE ${WORK_DIR}/first.cpp "// @tcc\n#include <tcc_prefix.h>\nint first() { return prefixValue(); }\n")
+file(WRITE ${WORK_DIR}/second.cpp "// @tcc\n#include <tcc_prefix.h>\nint second() { return prefixValue() + 1; }\n")
+
+function(run_check prefix)
+    execute_process(
+        COMMAND ${TCC_CHECK} --cache-dir=${WORK_DIR}/cache --pch --verbose
+                ${WORK_DIR}/first.cpp ${WORK_DIR}/second.cpp -- -I${include_dir}
+        RESULT_VARIABLE result
+        OUTPUT_VARIABLE out
+        ERROR_VARIABLE err
+    )
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${prefix} run exited with / 运行退出码 ${result}:\n${out}${err}")
+    endif()
+    set(${prefix}_out "${out}" PARENT_SCOPE)
+endfunction()
+
+set(built "Built shared PCH of 1 headers for 2 files")
+
+run_check(first)
+if(NOT first_out MATCHES "${built}")
+    message(FATAL_ERROR "First run built no shared PCH / 首次运行未构建共享 PCH:\n${first_out}")
+endif()
+
+run_check(second)
+if(NOT second_out MATCHES "Reusing shared PCH" OR second_out MATCHES "${built}")
+    message(FATAL_ERROR "Second run did not reuse the PCH / 第二次运行未复用 PCH:\n${second_out}")
+endif()
+
+# A changed header invalidates the PCH / 头文件改变使 PCH 失效
+file(APPEND ${header} "inline int prefixExtra() { return 2; }\n")
+run_check(edited)
+if(NOT edited_out MATCHES "${built}")
+    message(FATAL_ERROR "Edited header did not rebuild the PCH / 编辑头文件后未重建 PCH:\n${edited_out}")
+endif()
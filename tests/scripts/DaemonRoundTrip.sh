@@ -0,0 +1,68 @@
+#!/bin/sh
+# Tough C Tests - Daemon Round Trip
+# Tough C 测试 - 守护进程往返
+#
+# Starts tcc-checkd on a private socket and checks that tcc-check-client
+# returns tcc-check's output and exit codes through it. PATH is emptied for
+# the client so it cannot fall back to running tcc-check locally.
+# 在私有套接字上启动 tcc-checkd，检查 tcc-check-client 经由它返回 tcc-check 的输出和退出码。
+# 客户端的 PATH 被清空，因此无法回退到在本地运行 tcc-check。
+#
+# Usage / 用法: DaemonRoundTrip.sh <tcc-checkd> <tcc-check-client> <test data dir> <work dir>
+
+set -u
+checkd=$1
+client=$2
+data=$3
+work=$4
+
+rm -rf "$work"
+mkdir -p "$work"
+socket=$work/tcc-checkd.sock
+
+"$checkd" --socket="$socket" --cache-dir="$work/cache" 2>"$work/daemon.log" &
+daemon=$!
+trap 'kill "$daemon" 2>/dev/null' EXIT
+
+# Wait up to 10 s for the daemon to listen / 最多等待 10 秒直到守护进程开始监听
+tries=0
+until grep -q "listening" "$work/daemon.log" 2>/dev/null; do
+    tries=$((tries + 1))
+    if [ "$tries" -gt 100 ] || ! kill -0 "$daemon" 2>/dev/null; then
+        echo "tcc-checkd did not start / tcc-checkd 未能启动"
+        cat "$work/daemon.log"
+        exit 1
+    fi
+    sleep 0.1
+done
+
+# expect <exit code> <text in output> <client arguments...>
+# expect <退出码> <输出中的文本> <客户端参数...>
+failures=0
+expect() {
+    want=$1
+    text=$2
+    shift 2
+    output=$(TCC_CHECKD_SOCKET="$socket" PATH=/nonexistent "$client" "$@" 2>&1)
+    code=$?
+    case "$output" in
+        *"$text"*) found=1 ;;
+        *) found=0 ;;
+    esac
+    if [ "$code" -ne "$want" ] || [ "$found" -ne 1 ]; then
+        echo "FAILED / 失败: tcc-check-client $*"
+        echo "  exit code / 退出码: $code, expected / 预期: $want; expected text / 预期文本: $text"
+        echo "$output"
+        failures=$((failures + 1))
+    fi
+}
+
+expect 0 "All checks passed" "$data/pass/ownership_smart_pointers.cpp"
+expect 1 "[TCC-OWN-001]" "$data/fail/ownership_new_delete.cpp"
+expect 5 "Cannot read baseline" --baseline="$work/missing.baseline" \
+    "$data/fail/ownership_new_delete.cpp"
+
+# The daemon is still serving after a failed request / 失败的请求之后守护进程仍在服务
+expect 1 "Errors: 2" "$data/fail/ownership_new_delete.cpp"
+
+[ "$failures" -eq 0 ]
@@ -0,0 +1,76 @@
+#!/bin/sh
+# Tough C Tests - Watch Re-check
+# Tough C 测试 - 监视重新检查
+#
+# Runs tcc-check --watch on two files of which only one includes a header,
+# then edits the header and the other file and checks that each edit
+# re-checks exactly the file it affects.
+# 对两个文件运行 tcc-check --watch（只有其中一个包含头文件），然后编辑头文件和另一个文件，
+# 检查每次编辑只重新检查受其影响的文件。
+#
+# Usage / 用法: WatchRecheck.sh <tcc-check> <work dir>
+
+set -u
+check=$1
+work=$2
+
+rm -rf "$work"
+mkdir -p "$work"
+printf 'inline int shared() { return 1; }\n' >"$work/shared.h"
+printf '// @tcc\n#include "shared.h"\nint usesHeader() { return shared(); }\n' >"$work/uses_header.cpp"
+printf '// @tcc\nint standalone() { return 2; }\n' >"$work/standalone.cpp"
+
+"$check" --watch --verbose "$work/uses_header.cpp" "$work/standalone.cpp" -- \
+    >"$work/watch.out" 2>"$work/watch.log" &
+watcher=$!
+trap 'kill "$watcher" 2>/dev/null' EXIT
+
+# wait_for <count> <text>: up to 30 s until the log holds <count> lines with <text>
+# wait_for <次数> <文本>：最多等待 30 秒，直到日志中有 <次数> 行包含 <文本>
+wait_for() {
+    tries=0
+    until [ "$(grep -c "$2" "$work/watch.log")" -ge "$1" ]; do
+        tries=$((tries + 1))
+        if [ "$tries" -gt 300 ] || ! kill -0 "$watcher" 2>/dev/null; then
+            echo "Timed out waiting for / 等待超时: $2 (x$1)"
+            cat "$work/watch.out" "$work/watch.log"
+            exit 1
+        fi
+        sleep 0.1
+    done
+}
+
+# processed <file>: how often the watcher has checked <file>
+# processed <文件>：监视器检查 <文件> 的次数
+processed() {
+    grep -c "Processing file: .*/$1" "$work/watch.out"
+}
+
+expect_processed() {
+    if [ "$(processed uses_header.cpp)" -ne "$1" ] || [ "$(processed standalone.cpp)" -ne "$2" ]; then
+        echo "FAILED / 失败: $3"
+        echo "  uses_header.cpp: $(processed uses_header.cpp), expected / 预期: $1"
+        echo "  standalone.cpp: $(processed standalone.cpp), expected / 预期: $2"
+        cat "$work/watch.out" "$work/watch.log"
+        exit 1
+    fi
+}
+
+wait_for 1 "Watching 2 files"
+expect_processed 1 1 "initial run / 初次运行"
+
+# Only the includer of the header / 只有头文件的包含者
+printf 'inline int extra() { return 2; }\n' >>"$work/shared.h"
+wait_for 2 "Watching 2 files"
+expect_processed 2 1 "header edit / 编辑头文件"
+
+# Only the edited file itself / 只有被编辑的文件本身
+printf 'int more() { return 3; }\n' >>"$work/standalone.cpp"
+wait_for 3 "Watching 2 files"
+expect_processed 2 2 "source edit / 编辑源文件"
+
+if [ "$(grep -c "Re-checking 1 of 2 files" "$work/watch.log")" -ne 2 ]; then
+    echo "FAILED / 失败: expected two single-file re-checks / 预期两次单文件重新检查"
+    cat "$work/watch.log"
+    exit 1
+fi